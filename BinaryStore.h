@@ -0,0 +1,57 @@
+#ifndef BinaryStore_h
+#define BinaryStore_h
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <stdint.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Helpers shared by the on-disk stores (SVfitCache, SkimIndex):
+/// 64-bit FNV-1a hash of keys and configurations, and writing of
+/// a store into a temporary file moved in place once complete,
+/// so that readers never see a partly written store.
+class BinaryStore{
+
+ public:
+
+  ///Start value of hashes, extended by hashBytes() and hashValue()
+  static uint64_t hashSeed() {return 14695981039346656037ULL;}
+
+  static void hashBytes(uint64_t &hash, const void *data, size_t nBytes){
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for(size_t iByte=0;iByte<nBytes;++iByte){
+      hash ^= bytes[iByte];
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  template<typename T> static void hashValue(uint64_t &hash, const T &value) {hashBytes(hash, &value, sizeof(T));}
+
+  static void hashValue(uint64_t &hash, const std::string &value) {hashBytes(hash, value.data(), value.size()+1);}
+
+  ///Write content with writeContent(FILE*), which returns false on failure;
+  ///messages are reported as from owner
+  template<class Writer> static bool write(const std::string &fileName, const std::string &owner, Writer writeContent){
+
+    std::string tmpName = fileName+".tmp"+std::to_string((long)getpid());
+    FILE *aFile = fopen(tmpName.c_str(), "wb");
+    if(!aFile){
+      std::cout<<"["<<owner<<"]: Cannot write "<<tmpName<<std::endl;
+      return false;
+    }
+    bool ok = writeContent(aFile);
+    ok &= fclose(aFile)==0;
+    if(!ok || rename(tmpName.c_str(), fileName.c_str())!=0){
+      std::cout<<"["<<owner<<"]: Failed to write "<<fileName<<std::endl;
+      remove(tmpName.c_str());
+      return false;
+    }
+    return true;
+  }
+
+};
+
+#endif
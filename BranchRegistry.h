@@ -0,0 +1,104 @@
+#ifndef BranchRegistry_h
+#define BranchRegistry_h
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+
+#include "TTree.h"
+#include "TBranch.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Registry of input branches read by the converter.
+/// Each processing stage declares branches it reads, either
+/// as required (conversion is not possible without them) or
+/// optional (the stage copes with a missing branch, e.g. a
+/// trigger path or a property not present in all inputs).
+/// apply() switches off all branches of a tree and switches
+/// on the declared ones, so that GetEntry() reads only those.
+class BranchRegistry{
+
+ public:
+
+  BranchRegistry(){}
+
+  ~BranchRegistry(){}
+
+  void clear() {branches_.clear();}
+
+  bool empty() const {return branches_.empty();}
+
+  unsigned int size() const {return branches_.size();}
+
+  ///Declare a branch needed by the stage, missing branch is an error
+  void require(const std::string &stage, const std::string &name) {add(stage,name,true);}
+
+  ///Declare a branch used by the stage if present
+  void request(const std::string &stage, const std::string &name) {add(stage,name,false);}
+
+  ///Enable declared branches only. Returns false if a required branch
+  ///is missing in the tree, all missing ones are reported.
+  bool apply(TTree *tree) const {
+
+    if(tree==nullptr) return false;
+    bool allFound = true;
+    tree->SetBranchStatus("*",0);
+    for(std::map<std::string,Entry>::const_iterator it=branches_.begin();it!=branches_.end();++it){
+      if(tree->GetBranch(it->first.c_str())!=nullptr){
+	tree->SetBranchStatus(it->first.c_str(),1);
+	continue;
+      }
+      if(!it->second.required) continue;
+      std::cout<<"[BranchRegistry]: Branch "<<it->first
+	       <<" required by "<<it->second.stage<<" not found in the TTree"<<std::endl;
+      allFound = false;
+    }
+    return allFound;
+  }
+
+  ///Add declared branches present in the tree to its TTreeCache
+  void addToCache(TTree *tree) const {
+
+    if(tree==nullptr) return;
+    for(std::map<std::string,Entry>::const_iterator it=branches_.begin();it!=branches_.end();++it)
+      if(tree->GetBranch(it->first.c_str())!=nullptr) tree->AddBranchToCache(it->first.c_str(),kFALSE);
+  }
+
+  ///Number of declared branches present in the tree
+  unsigned int nFound(TTree *tree) const {
+
+    unsigned int n = 0;
+    for(std::map<std::string,Entry>::const_iterator it=branches_.begin();it!=branches_.end();++it)
+      if(tree!=nullptr && tree->GetBranch(it->first.c_str())!=nullptr) ++n;
+    return n;
+  }
+
+ private:
+
+  struct Entry {
+    std::string stage;//first stage requiring the branch (or requesting it if none does)
+    bool required;
+  };
+
+  void add(const std::string &stage, const std::string &name, bool required) {
+    if(name.empty()) return;
+    std::map<std::string,Entry>::iterator it = branches_.find(name);
+    if(it==branches_.end()){
+      Entry anEntry;
+      anEntry.stage = stage;
+      anEntry.required = required;
+      branches_[name] = anEntry;
+    }
+    else if(required && !it->second.required){
+      it->second.stage = stage;
+      it->second.required = true;
+    }
+  }
+
+  std::map<std::string,Entry> branches_;
+
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef CandidateKinematics_h
+#define CandidateKinematics_h
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "TLorentzVector.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Kinematics of a collection of candidates as parallel
+/// arrays, converted at once from the (pt,eta,phi) arrays
+/// of the input, and batch kernels on such arrays.
+/// Momenta and energies are computed as in
+/// TLorentzVector::SetPtEtaPhiM(), so p4() gives the same
+/// vectors bit by bit; these kernels call libm element by
+/// element. deltaR^2 has no calls or branches in its loop
+/// (phi wrap-around by selects) and is vectorized by the
+/// compiler. Phis are expected within [-pi,pi], as in NanoAOD.
+/// Storage is kept between events.
+class CandidateKinematics{
+
+ public:
+
+  CandidateKinematics(){}
+
+  ~CandidateKinematics(){}
+
+  ///Momenta of n candidates, input (eta,phi) are kept for matching
+  template<class T> void fill(unsigned int n, const T *pt, const T *eta, const T *phi){
+    eta_.resize(n);
+    phi_.resize(n);
+    px_.resize(n);
+    py_.resize(n);
+    pz_.resize(n);
+    e_.resize(n);
+    for(unsigned int i=0;i<n;++i){
+      eta_[i] = eta[i];
+      phi_[i] = phi[i];
+    }
+    momenta(n, pt, eta, phi, px_.data(), py_.data(), pz_.data());
+  }
+
+  ///Energies used by p4(i), with masses of each candidate
+  template<class T> void setMasses(const T *mass){
+    energies(size(), px_.data(), py_.data(), pz_.data(), mass, e_.data());
+  }
+
+  ///Energies used by p4(i), with the same mass for all candidates
+  void setMass(double mass){
+    energies(size(), px_.data(), py_.data(), pz_.data(), mass, e_.data());
+  }
+
+  unsigned int size() const {return px_.size();}
+
+  const double * eta() const {return eta_.data();}
+
+  const double * phi() const {return phi_.data();}
+
+  double eta(unsigned int i) const {return eta_[i];}
+
+  double phi(unsigned int i) const {return phi_[i];}
+
+  ///Magnitude of the momentum, as TLorentzVector::P()
+  double p(unsigned int i) const {return std::sqrt(px_[i]*px_[i]+py_[i]*py_[i]+pz_[i]*pz_[i]);}
+
+  ///Four-momentum with energy set by setMasses() or setMass()
+  TLorentzVector p4(unsigned int i) const {return TLorentzVector(px_[i], py_[i], pz_[i], e_[i]);}
+
+  ///Four-momentum with the given mass, as SetPtEtaPhiM() with this mass
+  TLorentzVector p4(unsigned int i, double mass) const {
+    TLorentzVector aP4;
+    aP4.SetXYZM(px_[i], py_[i], pz_[i], mass);
+    return aP4;
+  }
+
+  ///Cartesian momentum components from (pt,eta,phi)
+  template<class T> static void momenta(unsigned int n, const T *pt, const T *eta, const T *phi,
+					double *px, double *py, double *pz){
+    for(unsigned int i=0;i<n;++i){
+      double aPt = std::abs((double)pt[i]);
+      px[i] = aPt*std::cos((double)phi[i]);
+      py[i] = aPt*std::sin((double)phi[i]);
+      pz[i] = aPt*std::sinh((double)eta[i]);
+    }
+  }
+
+  ///Energies from momenta and masses, negative masses as in TLorentzVector::SetXYZM()
+  template<class T> static void energies(unsigned int n, const double *px, const double *py, const double *pz,
+					 const T *mass, double *e){
+    for(unsigned int i=0;i<n;++i){
+      double m = mass[i];
+      double m2 = m>=0 ? m*m : -m*m;
+      e[i] = std::sqrt(std::max(px[i]*px[i]+py[i]*py[i]+pz[i]*pz[i]+m2, 0.));
+    }
+  }
+
+  static void energies(unsigned int n, const double *px, const double *py, const double *pz,
+		       double mass, double *e){
+    double m2 = mass>=0 ? mass*mass : -mass*mass;
+    for(unsigned int i=0;i<n;++i) e[i] = std::sqrt(std::max(px[i]*px[i]+py[i]*py[i]+pz[i]*pz[i]+m2, 0.));
+  }
+
+  ///Phi difference limited to the [-pi,pi) range, for phis within [-pi,pi] as TVector2::Phi_mpi_pi()
+  static double deltaPhi(double phi1, double phi2){
+    double dPhi = phi1-phi2;
+    dPhi = dPhi>=M_PI ? dPhi-2.*M_PI : dPhi;
+    return dPhi<-M_PI ? dPhi+2.*M_PI : dPhi;
+  }
+
+  ///deltaR^2 between two directions
+  static double deltaR2(double eta1, double phi1, double eta2, double phi2){
+    double dEta = eta1-eta2;
+    double dPhi = deltaPhi(phi1, phi2);
+    return dEta*dEta+dPhi*dPhi;
+  }
+
+  ///deltaR^2 of n directions to the one of (eta0,phi0)
+  template<class T> static void deltaR2(unsigned int n, const T *eta, const T *phi,
+					double eta0, double phi0, double *dR2){
+    for(unsigned int i=0;i<n;++i) dR2[i] = deltaR2(eta[i], phi[i], eta0, phi0);
+  }
+
+  ///Transverse masses of n candidates with MET, sqrt(2*pt*MET*(1-cos(dphi)))
+  template<class T> static void transverseMass(unsigned int n, const T *pt, const T *phi,
+					       double metPt, double metPhi, double *mT){
+    for(unsigned int i=0;i<n;++i) mT[i] = std::sqrt(2.*pt[i]*metPt*(1.-std::cos(phi[i]-metPhi)));
+  }
+
+ private:
+
+  std::vector<double> eta_, phi_, px_, py_, pz_, e_;
+
+};
+
+#endif
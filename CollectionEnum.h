@@ -0,0 +1,7 @@
+enum class CollectionEnum {
+   Muon=0,
+   Electron=1,
+   Tau=2,
+   Jet=3,
+   NONE=4
+};
@@ -0,0 +1,116 @@
+#ifndef EntryRangeScheduler_h
+#define EntryRangeScheduler_h
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#include "TTree.h"
+#include "TChain.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Distribution of entry ranges of the input over threads.
+/// Ranges are dealt in contiguous blocks, one block per thread,
+/// so that threads progress roughly in input order. A thread which
+/// has no ranges left steals the last one of the thread with most
+/// ranges left. Finished ranges are reported with done() and can be
+/// waited for one by one with waitFor(), e.g. to merge in input order.
+class EntryRangeScheduler{
+
+ public:
+
+  struct Range {
+    Long64_t first, last;///entries [first,last)
+  };
+
+  EntryRangeScheduler(const std::vector<Range> &ranges, unsigned int nThreads) :
+    ranges_(ranges), queues_(nThreads>0 ? nThreads : 1), done_(ranges.size(), false) {
+
+    for(unsigned int iRange=0;iRange<ranges_.size();++iRange)
+      queues_[iRange*queues_.size()/ranges_.size()].push_back(iRange);
+  }
+
+  unsigned int size() const {return ranges_.size();}
+
+  const Range & range(unsigned int iRange) const {return ranges_[iRange];}
+
+  ///Next range to be converted by the thread, false if none is left
+  bool next(unsigned int iThread, unsigned int &iRange){
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::deque<unsigned int> &own = queues_[iThread];
+    if(!own.empty()){
+      iRange = own.front();
+      own.pop_front();
+      return true;
+    }
+    unsigned int iVictim = iThread;
+    for(unsigned int iQueue=0;iQueue<queues_.size();++iQueue)
+      if(queues_[iQueue].size()>queues_[iVictim].size()) iVictim = iQueue;
+    if(queues_[iVictim].empty()) return false;
+    iRange = queues_[iVictim].back();
+    queues_[iVictim].pop_back();
+    return true;
+  }
+
+  void done(unsigned int iRange){
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_[iRange] = true;
+    }
+    doneCondition_.notify_all();
+  }
+
+  void waitFor(unsigned int iRange){
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(!done_[iRange]) doneCondition_.wait(lock);
+  }
+
+  ///Split first nEntries of the tree in ranges of about rangeEntries entries.
+  ///Ranges do not cross files of a chain; for a single tree they start at cluster boundaries.
+  static std::vector<Range> split(TTree *tree, Long64_t nEntries, Long64_t rangeEntries){
+
+    std::vector<Range> ranges;
+    if(tree==nullptr || nEntries<=0) return ranges;
+    if(rangeEntries<1) rangeEntries = 1;
+
+    std::vector<Long64_t> fileBounds(1,0);
+    TChain *aChain = dynamic_cast<TChain*>(tree);
+    if(aChain!=nullptr){
+      aChain->GetEntries();//fills offsets of all files
+      for(int iFile=1;iFile<aChain->GetNtrees();++iFile)
+	if(aChain->GetTreeOffset()[iFile]<nEntries) fileBounds.push_back(aChain->GetTreeOffset()[iFile]);
+    }
+    fileBounds.push_back(nEntries);
+
+    for(unsigned int iFile=0;iFile+1<fileBounds.size();++iFile){
+      Long64_t fileEntries = fileBounds[iFile+1]-fileBounds[iFile];
+      Long64_t nRanges = (fileEntries+rangeEntries-1)/rangeEntries;
+      Range aRange;
+      aRange.first = fileBounds[iFile];
+      for(Long64_t iRange=1;iRange<=nRanges;++iRange){
+	aRange.last = fileBounds[iFile]+fileEntries*iRange/nRanges;
+	if(aChain==nullptr && iRange<nRanges) aRange.last = tree->GetClusterIterator(aRange.last).GetStartEntry();
+	if(aRange.last<=aRange.first) continue;
+	ranges.push_back(aRange);
+	aRange.first = aRange.last;
+      }
+    }
+    return ranges;
+  }
+
+ private:
+
+  std::vector<Range> ranges_;
+  std::vector<std::deque<unsigned int> > queues_;
+  std::vector<bool> done_;
+  std::mutex mutex_;
+  std::condition_variable doneCondition_;
+
+};
+
+#endif
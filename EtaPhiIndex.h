@@ -0,0 +1,70 @@
+#ifndef EtaPhiIndex_h
+#define EtaPhiIndex_h
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "CandidateKinematics.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Per-event index of objects sorted in eta used to
+/// preselect candidates for deltaR matching.
+/// query() returns indexes of all objects within a box
+/// |deta|<=dR && |dphi|<=dR (phi wrap-around handled),
+/// i.e. a superset of the dR cone, so the exact deltaR
+/// has to be still checked by the caller.
+/// Phis are expected within [-pi,pi], as in NanoAOD.
+/// Storage is kept between events.
+class EtaPhiIndex{
+
+ public:
+
+  struct Entry {
+    float eta, phi;
+    unsigned int index;
+  };
+
+  EtaPhiIndex(){}
+
+  ~EtaPhiIndex(){}
+
+  void clear() {entries.clear();}
+
+  void add(float eta, float phi, unsigned int index) {
+    Entry anEntry;
+    anEntry.eta = eta;
+    anEntry.phi = phi;
+    anEntry.index = index;
+    entries.push_back(anEntry);
+  }
+
+  ///Sort entries, to be called after all add() and before query()
+  void build() {std::sort(entries.begin(), entries.end(), lessEta);}
+
+  unsigned int size() const {return entries.size();}
+
+  ///Fill indexes (in increasing order) of candidates around (eta,phi)
+  void query(double eta, double phi, double dR, std::vector<unsigned int> &indexes) const {
+    indexes.clear();
+    //small margin to not loose candidates on the edge due to float precision
+    double dRbox = dR*(1+1E-4)+1E-5;
+    Entry aLowEdge;
+    aLowEdge.eta = eta-dRbox;
+    std::vector<Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), aLowEdge, lessEta);
+    for(; it!=entries.end() && it->eta<=eta+dRbox; ++it){
+      if(std::abs(CandidateKinematics::deltaPhi(it->phi,phi))<=dRbox) indexes.push_back(it->index);
+    }
+    std::sort(indexes.begin(), indexes.end());
+  }
+
+ private:
+
+  static bool lessEta(const Entry &a, const Entry &b) {return a.eta<b.eta;}
+
+  std::vector<Entry> entries;
+
+};
+
+#endif
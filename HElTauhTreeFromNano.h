@@ -25,6 +25,7 @@ class HElTauhTreeFromNano : public HTauTauTreeFromNanoBase {
   
   HElTauhTreeFromNano(TTree *tree=0, bool doSvFit=false, bool correctRecoil=false, std::vector<std::string> lumis = std::vector<std::string>(), std::string prefix="HTTET");
   virtual ~HElTauhTreeFromNano();
+  HTauTauTreeFromNanoBase *newWorker(TTree *tree, std::string prefix);
   
 };
 
@@ -37,4 +38,7 @@ HElTauhTreeFromNano::HElTauhTreeFromNano(TTree *tree, bool doSvFit, bool correct
 HElTauhTreeFromNano::~HElTauhTreeFromNano()
 {}
 
+HTauTauTreeFromNanoBase *HElTauhTreeFromNano::newWorker(TTree *tree, std::string prefix)
+{return new HElTauhTreeFromNano(tree, false, recoilCorrector_!=nullptr, std::vector<std::string>(), prefix);}
+
 #endif // #ifdef HElTauhTreeFromNano_cxx
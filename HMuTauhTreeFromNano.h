@@ -25,6 +25,7 @@ class HMuTauhTreeFromNano : public HTauTauTreeFromNanoBase {
   
   HMuTauhTreeFromNano(TTree *tree=0, bool doSvFit=false, bool correctRecoil=false, std::vector<std::string> lumis = std::vector<std::string>(), std::string prefix="HTTMT");
   virtual ~HMuTauhTreeFromNano();
+  HTauTauTreeFromNanoBase *newWorker(TTree *tree, std::string prefix);
   
 };
 
@@ -37,4 +38,7 @@ HMuTauhTreeFromNano::HMuTauhTreeFromNano(TTree *tree, bool doSvFit, bool correct
 HMuTauhTreeFromNano::~HMuTauhTreeFromNano()
 {}
 
+HTauTauTreeFromNanoBase *HMuTauhTreeFromNano::newWorker(TTree *tree, std::string prefix)
+{return new HMuTauhTreeFromNano(tree, false, recoilCorrector_!=nullptr, std::vector<std::string>(), prefix);}
+
 #endif // #ifdef HMuTauhTreeFromNano_cxx
@@ -75,6 +75,17 @@ void HTTEvent::clear(){
 }
 ////////////////////////////////////////////////
 ////////////////////////////////////////////////
+constexpr unsigned int HTTParticle::kNProperties;
+////////////////////////////////////////////////
+////////////////////////////////////////////////
+void HTTParticle::propertyIndexError(unsigned int index){
+
+  std::cout<<"[HTTParticle]: Property index "<<index<<" out of range, "<<kNProperties
+	   <<" properties compiled (regenerated PropertyEnum.h/JecUncEnum.h need recompilation)"<<std::endl;
+  throw std::out_of_range("HTTParticle property index "+std::to_string(index)+" out of range");
+}
+////////////////////////////////////////////////
+////////////////////////////////////////////////
 void HTTParticle::clear(){
 
   p4*=0;
@@ -85,7 +96,7 @@ void HTTParticle::clear(){
   pcaRefitPV*=0;
   pcaGenPV*=0;
 
-  properties.clear();
+  std::fill(properties, properties+kNProperties, -999);
 
   lastSystEffect = HTTAnalysis::NOMINAL;
 }
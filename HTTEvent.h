@@ -6,8 +6,11 @@
 #include "TBits.h"
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <bitset>
 #include <iostream>
+#include <string>
+#include <stdexcept>
 
 #include "PropertyEnum.h"
 #include "JecUncEnum.h"
@@ -251,7 +254,21 @@ class HTTParticle{
 
   void setPCAGenPV(const TVector3 &aV3) {pcaGenPV = aV3;}
 
-  void setProperties(const std::vector<Double_t> & aProperties) { properties = aProperties;}
+  ///Properties indexed by PropertyEnum, followed for jets by up and down JEC uncertainties
+  ///indexed by JecUncEnum; properties which are not set read as -999
+  static constexpr unsigned int kNProperties = (unsigned int)PropertyEnum::NONE+2*(unsigned int)JecUncEnum::NONE;
+
+  ///Index beyond kNProperties (e.g. enums regenerated after compilation) throws std::out_of_range
+  void setProperty(unsigned int index, Double_t value) {
+    if(index>=kNProperties) propertyIndexError(index);
+    properties[index] = value;
+  }
+
+  void setProperty(PropertyEnum index, Double_t value) { setProperty((unsigned int)index, value);}
+
+  void setProperties(const std::vector<Double_t> & aProperties) {
+    for(unsigned int index=0;index<aProperties.size();++index) setProperty(index, aProperties[index]);
+  }
 
   ///Data member getters.
   const TLorentzVector & getP4(HTTAnalysis::sysEffects type=HTTAnalysis::NOMINAL) const {return getSystScaleP4(type);}
@@ -270,13 +287,15 @@ class HTTParticle{
 
   int getCharge() const {return getProperty(PropertyEnum::charge);}
 
-  Double_t getProperty(PropertyEnum index) const {return (unsigned int)index<properties.size()?  properties[(unsigned int)index]: -999;}
+  Double_t getProperty(PropertyEnum index) const {return (unsigned int)index<kNProperties?  properties[(unsigned int)index]: -999;}
 
   bool hasTriggerMatch(TriggerEnum index) const {return (unsigned int)getProperty(PropertyEnum::isGoodTriggerType)& (1<<(unsigned int)index) &&
                                                         (unsigned int)getProperty(PropertyEnum::FilterFired)& (1<<(unsigned int)index);}
 
  private:
 
+  static void propertyIndexError(unsigned int index);
+
   ///Return four-momentum modified according DATA/MC energy scale factors.
   const TLorentzVector & getNominalShiftedP4() const;
 
@@ -303,10 +322,12 @@ class HTTParticle{
   ///calculated with respect to AOD vertex, refitted and generated vertex.
   TVector3 pca, pcaRefitPV, pcaGenPV;
 
-  ///Vector of various particle properties.
+  ///Block of various particle properties.
   ///Index generated automatically during conversion from
-  ///LLR ntuple format
-  std::vector<Double_t> properties;
+  ///LLR ntuple format. Double_t as computed values
+  ///(e.g. JEC uncertainties, shifted MVA outputs) are stored too.
+  Double_t properties[kNProperties];
+  static_assert((unsigned int)TriggerEnum::NONE<=32, "Trigger bitmasks have to fit in unsigned int");
 
   //Corrections of nominal tau-scale: https://twiki.cern.ch/twiki/bin/view/CMS/TauIDRecommendation13TeV#Tau_energy_scale 
   /*dummy
@@ -391,7 +412,7 @@ class HTTPair{
 
   float getMTMuon(HTTAnalysis::sysEffects type = HTTAnalysis::NOMINAL) const {return abs(leg1.getPDGid())==13 ? getMTLeg1(type) : getMTLeg2(type); }
 
-  std::vector<float> getMETMatrix() const {return metMatrix;}
+  const std::vector<float> & getMETMatrix() const {return metMatrix;}
 
  private:
 
@@ -0,0 +1,21 @@
+#ifdef __CLING__
+
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+///Classes stored in the output tree
+#pragma link C++ class HTTEvent+;
+#pragma link C++ class HTTParticle+;
+#pragma link C++ class HTTPair+;
+#pragma link C++ class std::vector<HTTParticle>+;
+#pragma link C++ class std::vector<HTTPair>+;
+
+///Converters, for use from python
+#pragma link C++ class NanoEventsSkeleton;
+#pragma link C++ class HTauTauTreeFromNanoBase;
+#pragma link C++ class HMuTauhTreeFromNano;
+#pragma link C++ class HElTauhTreeFromNano;
+#pragma link C++ class HTauhTauhTreeFromNano;
+
+#endif
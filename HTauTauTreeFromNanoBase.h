@@ -19,12 +19,24 @@
 #include <TH1F.h>
 #include <TH2F.h>
 #include <TMatrixD.h>
+#include <TLeaf.h>
 #include "Math/PtEtaPhiE4D.h"
 #include "Math/PtEtaPhiM4D.h"
 #include "Math/LorentzVector.h"
 
 #include "HTTEvent.h"
+#include "CollectionEnum.h"
+#include "EtaPhiIndex.h"
+#include "CandidateKinematics.h"
+#include "SVfitWorkerPool.h"
+#include "SVfitCache.h"
+#include "SkimIndex.h"
+#include "BranchRegistry.h"
+#include "EntryRangeScheduler.h"
+#include "LumiMask.h"
+#include "StageTimer.h"
 #include <vector>
+#include <deque>
 #include <iostream>
 
 #include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
@@ -33,10 +45,8 @@
 
 #include "HTT-utilities/RecoilCorrections/interface/RecoilCorrector.h"
 
-#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
-#include "CondFormats/JetMETObjects/interface/JetCorrectionUncertainty.h"
+#include "JecUncertaintyTable.h"
 
-#include "DataFormats/Provenance/interface/LuminosityBlockRange.h"
 
 class HTauTauTreeFromNanoBase : public NanoEventsSkeleton {
 public :
@@ -54,6 +64,36 @@ public :
     float leg1Eta, leg2Eta;
     float leg1OfflinePt;
   };
+  /// Accessor to a property of a collection, resolved once per input file
+  struct PropertyAccessor {
+    enum Kind {kConstant, kLeaf, kTauPdgId, kGenMatch, kTriggerMatch, kFilterFired, kByName};
+    enum LeafType {kOther, kFloat, kDouble, kInt, kUInt, kChar, kUChar, kBool, kShort, kUShort, kLong64, kULong64};
+    Kind kind;
+    LeafType type;
+    const void *address;//points directly to the array of the skeleton
+    TLeaf *leaf;
+    Double_t constant;
+    std::string name;//used only for kByName
+  };
+
+  ///Pair of leptons given by indexes in httLeptonCollection
+  struct PairCandidate {
+    unsigned int indexLeg1, indexLeg2;
+    unsigned int getIndexLeg1() const {return indexLeg1;}
+    unsigned int getIndexLeg2() const {return indexLeg2;}
+  };
+
+  ///Order of leptons in candidate pairs: type (mu, e, tau),
+  ///isolation (most isolated first), pt (highest first)
+  struct LeptonKey {
+    unsigned int type;
+    double iso, pt;
+    bool operator<(const LeptonKey &other) const {
+      if(type!=other.type) return type<other.type;
+      if(iso!=other.iso) return iso<other.iso;
+      return pt>other.pt;
+    }
+  };
 
   virtual void initHTTTree(const TTree *tree, std::string prefix="HTT");
   void initJecUnc(std::string correctionFile);
@@ -68,19 +108,63 @@ public :
   virtual bool thirdLeptonVeto(unsigned int signalLeg1Index, unsigned int signalLeg2Index, int leptonPdg, double dRmin=-1);
   virtual bool extraMuonVeto(unsigned int signalLeg1Index, unsigned int signalLeg2Index, double dRmin=-1);
   virtual bool extraElectronVeto(unsigned int signalLeg1Index, unsigned int signalLeg2Index, double dRmin=-1);
+  ///deltaR^2 of two leptons from directions cached by buildPairs()
+  double leptonDeltaR2(unsigned int iL1, unsigned int iL2) const {
+    return CandidateKinematics::deltaR2(leptonEta_[iL1], leptonPhi_[iL1], leptonEta_[iL2], leptonPhi_[iL2]);
+  }
   bool muonSelection(unsigned int index);
   bool electronSelection(unsigned int index);
   bool failsGlobalSelection();
+  bool fillLeptonsAndPairs();
+  Int_t loadPreselectionBranches(Long64_t ientry);
+  bool passesPreselection();
+  void fillRejectedEventStats(Long64_t ientry);
+  unsigned int selectBestPair(HTauTauTreeFromNanoBase *aChannel);
+  bool selectPair(HTauTauTreeFromNanoBase *aChannel, unsigned int iPair);
+  void fillChannel(HTauTauTreeFromNanoBase *aChannel, bool hasPairs, Long64_t jentry);
+  void loopRange(Long64_t firstEntry, Long64_t lastEntry);
+  void loopParallel(Long64_t nentries);
+  void mergeWorkerOutputs(HTauTauTreeFromNanoBase &aWorker);
+  HTauTauTreeFromNanoBase *buildWorker(Long64_t firstEntry, unsigned int iRange, TChain *&input);
+  void deleteWorker(HTauTauTreeFromNanoBase *aWorker);
+  ///Converter of the same channel and options reading the given input, used by loopParallel()
+  virtual HTauTauTreeFromNanoBase *newWorker(TTree *tree, std::string prefix) {return nullptr;}
+  void swapChannelOutputs(HTauTauTreeFromNanoBase &aChannel);
+  void lendEventData(HTauTauTreeFromNanoBase &aChannel);
+  void flushChannelsSvFit();
+  virtual void declareBranches(BranchRegistry &registry);
+  bool activateBranches();
+  void initTreeCache();
+  void printTreeCacheStats();
+  void writeStageTimes();
+  static std::vector<std::string> loopStageNames();
   virtual bool pairSelection(unsigned int index);
   virtual unsigned int bestPair(std::vector<unsigned int> &pairIndexes);
+  ///True if bestPair() takes the first passing pair, so generation of pairs can stop there
+  virtual bool firstPassingPairIsBest() const {return true;}
   void computeSvFit(HTTPair &aPair, HTTAnalysis::sysEffects type=HTTAnalysis::NOMINAL);
-  TLorentzVector runSVFitAlgo(const std::vector<classic_svFit::MeasuredTauLepton> & measuredTauLeptons,
-			      const TVector2 &aMET, const TMatrixD &covMET);
+  long prepareSvFit(const HTTPair &aPair, HTTAnalysis::sysEffects type, SVfitRequest &aRequest);
+  void setSvFitResult(HTTPair &aPair, const TLorentzVector &p4SVFit, HTTAnalysis::sysEffects type);
+  TLorentzVector runSVFitAlgo(const SVfitRequest &aRequest);
+  TLorentzVector getSvFitP4(const SVfitResult &aResult);
+  void openSvFitCache(TTree *input);
+  void openSkimIndex();
+  void closeSkimIndex();
+  void mergeSkimIndex(HTauTauTreeFromNanoBase &aWorker);
+  uint64_t skimIndexHash(const std::string &channelName);
+  std::string skimIndexPath(const HTauTauTreeFromNanoBase *aChannel) const;
+  void submitSvFit(HTTPair &aPair);
+  bool queueSvFit() const {return deferSvFit_ || (svFitAlgo_ && svFitPool_ && svFitPool_->size());}
+  void flushSvFit(unsigned int maxPending=0);
   bool jetSelection(unsigned int index, unsigned int bestPairIndex);
   int getGenMatch(unsigned int index, std::string colType="");
   int getGenMatch(TLorentzVector selObj);
+  int getGenMatch(double selEta, double selPhi);
   //  int getTriggerMatching(unsigned int index, bool checkBit=false, std::string colType="");
   int getTriggerMatching(unsigned int index, TLorentzVector p4_1, bool checkBit=false, std::string colType="");
+  void getTriggerMatching(const TLorentzVector &p4_1, unsigned int particleId, int &firedBits, int &firedBitsWithFilter);
+  void fillTriggerDecisions();
+  void fillGenMatchingIndex();
   int getMetFilterBits();
   double getPtReweight(const TLorentzVector &genBosonP4, bool doSUSY=false);
   bool isGoodToMatch(unsigned int ind);
@@ -92,6 +176,15 @@ public :
   Double_t getProperty(std::string name, unsigned int index, TLorentzVector obj, std::string colType="");
   std::vector<Double_t> getProperties(const std::vector<std::string> & propertiesList, unsigned int index, std::string colType="");
   std::vector<Double_t> getProperties(const std::vector<std::string> & propertiesList, unsigned int index, TLorentzVector obj, std::string colType="");
+  void fillProperties(CollectionEnum colType, unsigned int index, const TLorentzVector &obj, HTTParticle &aParticle);
+  Double_t getProperty(const PropertyAccessor &accessor, unsigned int index, const TLorentzVector &obj, CollectionEnum colType);
+  Double_t getLeafValue(const PropertyAccessor &accessor, unsigned int index);
+  PropertyAccessor resolvePropertyAccessor(std::string name, CollectionEnum colType);
+  void resolveLeafType(PropertyAccessor &accessor);
+  void initPropertyAccessors();
+  void initTriggerAccessors();
+  static std::string collectionName(CollectionEnum colType);
+  static unsigned int collectionPdgId(CollectionEnum colType);
 
   Int_t getFilter(std::string name);
   std::vector<Int_t> getFilters(const std::vector<std::string> & propertiesList);
@@ -99,11 +192,11 @@ public :
   void writePropertiesHeader(const std::vector<std::string> & propertiesList);
   void writeTriggersHeader(const std::vector<TriggerData> &triggerBits);
   void writeFiltersHeader(const std::vector<std::string> &filterBits);
-  double getJecUnc(unsigned int index, std::string name="Total", bool up=true);
   static bool compareLeptons(const HTTParticle& i, const HTTParticle& j);
-  static bool comparePairs(const HTTPair& i, const HTTPair& j);
+  static LeptonKey leptonSortKey(const HTTParticle& aLepton);
   //int isGenPartDaughterPdgId(int index, unsigned int aPdgId);
   //bool isGenPartDaughterIdx(int index, int mother);
+  void buildGenDaughterIndex();
   bool getDirectDaughterIndexes(std::vector<unsigned int> & indexes, unsigned int motherIndex, bool ignoreNeutrinos=true);
   unsigned int findFinalCopy(unsigned int index);
   unsigned int findFirstCopy(unsigned int index);
@@ -111,12 +204,46 @@ public :
   bool findBosonP4(TLorentzVector &bosonP4, TLorentzVector &visBosonP4);
   bool findTopP4(TLorentzVector &topP4, TLorentzVector &antiTopP4);
 
-  std::vector<HTTPair> httPairCollection, httPairs_;
+  std::vector<HTTPair> httPairCollection;
+  ///Candidate pairs as indexes of httLeptonCollection in the order they were
+  ///generated by selectBestPair(), and the ones passing pairSelection()
+  std::vector<PairCandidate> httPairs_;
+  std::vector<unsigned int> passedPairs_;
+  ///Sort keys of leptons and lepton indexes ordered by them, filled by buildPairs()
+  std::vector<LeptonKey> leptonKeys_;
+  std::vector<unsigned int> leptonOrder_;
+  ///Directions and transverse masses of leptons, filled by buildPairs()
+  std::vector<double> leptonPt_, leptonEta_, leptonPhi_, leptonMT_;
   std::vector<HTTParticle> httJetCollection;
+  ///Kinematics and properties of httJetCollection read when filling the TauCheck tree
+  SyncJetTable syncJets_;
   std::vector<HTTParticle> httLeptonCollection;
   std::vector<HTTParticle> httGenLeptonCollection;
   std::vector<TriggerData> triggerBits_;
+  std::vector<PropertyAccessor> triggerAccessors_;//decisions of triggerBits_ paths, rebuilt in Notify()
+  int firedTriggers_;//paths of triggerBits_ fired in the current event
+  ///Per-event eta-phi indexes used for deltaR matching
+  EtaPhiIndex trigObjIndex_, genLeptonIndex_, genTauhIndex_;
+  ///Per-event kinematics of all jets and gen particles of the input
+  CandidateKinematics jetKinematics_, genKinematics_;
+  ///deltaR^2 outputs of batch kernels, one set per stage: of leptons to others in buildPairs(),
+  ///of leptons to legs in thirdLeptonVeto(), of jets to legs of the best pair from fillJets()
+  ///(read by jetSelection())
+  std::vector<double> pairDR2_, vetoDR2Leg1_, vetoDR2Leg2_, jetDR2Leg1_, jetDR2Leg2_;
+  std::vector<double> genTauhVisEta_, genTauhVisPhi_;//visible gen tau_h directions indexed by genTauhIndex_
+  std::vector<unsigned int> matchCandidates_;
+  std::vector<double> preselEta_, preselPhi_;//directions of lepton candidates passing preselection
+  ///Per-event GenPart mother->daughters index in CSR format: daughters of i are
+  ///genDaughters_[genDaughterOffsets_[i]..genDaughterOffsets_[i+1]), in increasing order
+  std::vector<unsigned int> genDaughterOffsets_, genDaughters_;
+  ///Per-event cache of first/last copies (-1: not yet resolved)
+  std::vector<int> genFirstCopy_, genFinalCopy_;
   std::vector<std::string> filterBits_;
+  ///Input branches read by the conversion, only those are enabled in Loop()
+  BranchRegistry branchRegistry_;
+  ///Input TTreeCache: size in bytes (<0: ROOT default), entries to learn (0: only declared branches), async prefetch
+  Long64_t treeCacheSize_, treeCacheLearnEntries_;
+  bool treeCachePrefetch_;
   TTree *t_TauCheck;
   //  std::unique_ptr<syncDATA> SyncDATA;
   syncDATA *SyncDATA;
@@ -128,15 +255,59 @@ public :
   TH2F* zptmass_histo, *zptmass_histo_SUSY;
   
   unsigned int bestPairIndex_;
+  int tauCheckEntry_;
+
+  ///Other channels converted in the same pass over the input, see addChannel()
+  std::vector<HTauTauTreeFromNanoBase*> channels_;
 
   int passMask_;
 
   ClassicSVfit *svFitAlgo_;
+  ///Workers running SVfit in parallel to the event loop, created in Loop() if svFitWorkers_>0
+  SVfitWorkerPool *svFitPool_;
+  unsigned int svFitWorkers_;
+  ///Selected pair and TauCheck row of an event waiting for SVfit results, filled in input order
+  struct PendingSvFit {
+    syncDATA row;
+    HTTPair pair;
+    std::vector<SVfitRequest> requests;
+    std::vector<SVfitResult> results;
+    std::vector<long> tickets;///per systematic: pool ticket or one of kSvFit* actions
+  };
+  std::deque<PendingSvFit> pendingSvFit_;
+  void dispatchSvFit(PendingSvFit &aPending);
+  ///Keep selected pairs for SVfit in pendingSvFit_ to be computed by another converter (see loopParallel())
+  bool deferSvFit_;
+  ///Threads converting entry ranges of the input, each range with its own converter
+  unsigned int loopThreads_;
+  Long64_t loopRangeEntries_;
+  std::string prefix_;
+  ///Stages of the event loop timed by stageTimer_, see loopStageNames()
+  enum LoopStage {kStagePreselectionEntry, kStageGetEntry, kStageEventInJson, kStageFillLeptons, kStageBuildPairs,
+		  kStagePairSelection, kStageFillEvent, kStageFillJets, kStageFillGenLeptons, kStageMetRecoil,
+		  kStageSvFit, kStageSyncFill, kStageTauCheckFill, kNLoopStages};
+  ///Stages common to all channels are timed by the converter running the loop, the others by each channel
+  StageTimer *stageTimer_;
+  enum SvFitAction {kSvFitSkip=-1, kSvFitCopyNominal=-2, kSvFitRun=-3, kSvFitCached=-4};
+  ///SVfit results of previous runs, one store per input file in svFitCacheDir_
+  SVfitCache svFitCache_;
+  std::string svFitCacheDir_;
+  ///Number of the input file of the open store in its chain
+  int svFitCacheTreeNumber_;
+  ///Entries of previous runs with a TauCheck row, one list per input file and channel in skimIndexDir_.
+  ///skimIndex_ of each channel is read from (or recorded for) the current file by the converter running
+  ///the loop, which skips entries absent from all lists (skimSelection_) when every list is valid.
+  ///Lists are written once all entries of a file are read (skimEntriesRead_), also over several ranges.
+  SkimIndex skimIndex_, skimSelection_;
+  std::string skimIndexDir_, skimPrefix_, skimFileName_;
+  int skimTreeNumber_;
+  Long64_t skimFileEntries_, skimEntriesRead_;
+  bool skimSelecting_, skimRecording_;
   RecoilCorrector* recoilCorrector_;
   TFile* zPtReweightFile, *zPtReweightSUSYFile;
   TLorentzVector p4SVFit, p4Leg1SVFit, p4Leg2SVFit;   
 
-  std::vector<edm::LuminosityBlockRange> jsonVector;
+  LumiMask lumiMask_;
 
   bool firstWarningOccurence_; // used to print warnings only at first occurnece in the event loop
 
@@ -144,13 +315,42 @@ public :
 
   bool tweak_nano;
 
-  std::vector<std::string> leptonPropertiesList, genLeptonPropertiesList, jecUncertList;
-  std::vector<JetCorrectionUncertainty*> jecUncerts;
+  std::vector<std::string> leptonPropertiesList, genLeptonPropertiesList;
+  ///Accessors of leptonPropertiesList entries per collection, rebuilt in Notify()
+  std::vector<PropertyAccessor> propertyAccessors_[(unsigned int)CollectionEnum::NONE];
+  ///JEC uncertainty sources indexed by JecUncEnum, with buffers of up/down shifts of a jet
+  JecUncertaintyTable jecUncTable_;
+  std::vector<double> jecUncUp_, jecUncDown_;
 
   HTauTauTreeFromNanoBase(TTree *tree=0, bool doSvFit=false, bool correctRecoil=false, std::vector<std::string> lumis = std::vector<std::string>(), string prefix="HTT");
   virtual ~HTauTauTreeFromNanoBase();
   virtual Int_t    Cut(Long64_t entry);
+  virtual Bool_t   Notify();
   virtual void     Loop(Long64_t nentries_max=-1, unsigned int sync_event=-1);
+  ///Convert also another channel in the same pass: leptons, pairs and event information are
+  ///built once by this converter, the added one runs its pair selection and fills its own outputs.
+  ///It has to be built on the same tree, it is used only through this converter afterwards.
+  void             addChannel(HTauTauTreeFromNanoBase *aChannel);
+  ///Number of worker processes for SVfit, 0 to run it within the event loop
+  void             setSvFitWorkers(unsigned int nWorkers) {svFitWorkers_ = nWorkers;}
+  ///Directory of SVfit result stores, empty to not use them
+  void             setSvFitCacheDir(std::string dirName) {svFitCacheDir_ = dirName;}
+  ///Directory of lists of entries with a TauCheck row, empty to not use them. Entries of an input file
+  ///absent from the lists of all channels are only counted in hStats when the lists were written with
+  ///the same selection and lumi mask, otherwise all are converted and the lists are written anew
+  void             setSkimIndexDir(std::string dirName) {skimIndexDir_ = dirName;}
+  ///Number of threads converting the input (also a chain of files) in ranges of about rangeEntries
+  ///entries (0: a few ranges per thread); outputs are merged in input order and SVfit runs after merging
+  void             setLoopThreads(unsigned int nThreads, Long64_t rangeEntries=0) {
+    loopThreads_ = nThreads; loopRangeEntries_ = rangeEntries;
+  }
+  ///Cache of the input tree: size in bytes (<0: ROOT default, 0: no cache), number of entries used
+  ///to learn which branches are read (0: only declared ones), asynchronous prefetching of next clusters
+  void             setTreeCache(Long64_t cacheSize, Long64_t learnEntries=0, bool prefetch=false) {
+    treeCacheSize_ = cacheSize; treeCacheLearnEntries_ = learnEntries; treeCachePrefetch_ = prefetch;
+  }
+  ///Time stages of the event loop, summary is printed and stored as StageTimes tree in the outputs
+  void             setStageTimes(bool enabled) {stageTimer_->enable(enabled);}
 };
 
 #endif
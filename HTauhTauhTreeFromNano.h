@@ -21,10 +21,13 @@ class HTauhTauhTreeFromNano : public HTauTauTreeFromNanoBase {
   /// TT final state specific
   bool pairSelection(unsigned int index);
   unsigned int bestPair(std::vector<unsigned int> &pairIndexes);
+  ///Best pair is chosen among all passing ones, also with legs inverted
+  bool firstPassingPairIsBest() const {return false;}
   /////////////////////////////////////////////////
   
   HTauhTauhTreeFromNano(TTree *tree=0, bool doSvFit=false, bool correctRecoil=false, std::vector<std::string> lumis = std::vector<std::string>(), std::string prefix="HTTTT");
   virtual ~HTauhTauhTreeFromNano();
+  HTauTauTreeFromNanoBase *newWorker(TTree *tree, std::string prefix);
   
 };
 
@@ -37,4 +40,7 @@ HTauhTauhTreeFromNano::HTauhTauhTreeFromNano(TTree *tree, bool doSvFit, bool cor
 HTauhTauhTreeFromNano::~HTauhTauhTreeFromNano()
 {}
 
+HTauTauTreeFromNanoBase *HTauhTauhTreeFromNano::newWorker(TTree *tree, std::string prefix)
+{return new HTauhTauhTreeFromNano(tree, false, recoilCorrector_!=nullptr, std::vector<std::string>(), prefix);}
+
 #endif // #ifdef HTauhTauhTreeFromNano_cxx
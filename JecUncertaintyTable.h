@@ -0,0 +1,173 @@
+#ifndef JecUncertaintyTable_h
+#define JecUncertaintyTable_h
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// JEC uncertainties of several sources read once from a
+/// file of uncertainty sources, in the order of addSource()
+/// calls (i.e. of JecUncEnum). Values are stored per eta bin
+/// and pt point with up and down shifts of all sources next
+/// to each other, so one evaluate() finds the eta bin and pt
+/// segment once and interpolates all sources in one pass.
+/// As in JetCorrectionUncertainty, interpolation in pt is linear
+/// with values of the first/last point outside the points, and
+/// jets outside of eta bins get -999.
+/// Sources with binning different from the first one are
+/// kept separately and evaluated with their own binning.
+class JecUncertaintyTable{
+
+ public:
+
+  JecUncertaintyTable() {}
+
+  ~JecUncertaintyTable(){}
+
+  unsigned int size() const {return names_.size();}
+
+  const std::string & name(unsigned int iSource) const {return names_[iSource];}
+
+  ///Read one source (section [name] of the file), false if it is malformed
+  bool addSource(const std::string &fileName, const std::string &name){
+
+    JetCorrectorParameters parameters(fileName, name);
+    Grid aGrid;
+    for(unsigned int iBin=0;iBin<parameters.size();++iBin){
+      const JetCorrectorParameters::Record &aRecord = parameters.record(iBin);
+      const std::vector<float> &values = aRecord.parameters();
+      if(values.size()<6 || values.size()%3!=0){
+	std::cout<<"[JecUncertaintyTable]: Source "<<name<<" has no pt points in eta bin "<<iBin<<std::endl;
+	return false;
+      }
+      if(iBin==0) aGrid.etaEdges.push_back(aRecord.xMin(0));
+      aGrid.etaEdges.push_back(aRecord.xMax(0));
+      std::vector<float> pts;
+      for(unsigned int iPoint=0;3*iPoint<values.size();++iPoint) pts.push_back(values[3*iPoint]);
+      if(iBin==0) aGrid.pts = pts;
+      else if(pts!=aGrid.pts){
+	std::cout<<"[JecUncertaintyTable]: Source "<<name<<" has different pt points in eta bins"<<std::endl;
+	return false;
+      }
+      aGrid.values.push_back(values);
+    }
+    if(aGrid.etaEdges.empty()) return false;
+
+    unsigned int iSource = names_.size();
+    names_.push_back(name);
+    if(shared_.pts.empty() || sameBinning(aGrid, shared_)){
+      if(shared_.pts.empty()){
+	shared_.etaEdges = aGrid.etaEdges;
+	shared_.pts = aGrid.pts;
+	shared_.values.resize(aGrid.values.size());
+      }
+      shared_.sources.push_back(iSource);
+      ///[eta bin][pt point][source][up,down]
+      for(unsigned int iBin=0;iBin<aGrid.values.size();++iBin){
+	std::vector<float> &row = shared_.values[iBin];
+	std::vector<float> merged;
+	unsigned int nOld = shared_.sources.size()-1;
+	for(unsigned int iPoint=0;iPoint<aGrid.pts.size();++iPoint){
+	  merged.insert(merged.end(), row.begin()+2*nOld*iPoint, row.begin()+2*nOld*(iPoint+1));
+	  merged.push_back(aGrid.values[iBin][3*iPoint+1]);
+	  merged.push_back(aGrid.values[iBin][3*iPoint+2]);
+	}
+	row.swap(merged);
+      }
+    }
+    else{
+      std::cout<<"[JecUncertaintyTable]: Source "<<name<<" has own binning, evaluated separately"<<std::endl;
+      ///Same layout with one source
+      for(unsigned int iBin=0;iBin<aGrid.values.size();++iBin){
+	std::vector<float> row;
+	for(unsigned int iPoint=0;iPoint<aGrid.pts.size();++iPoint){
+	  row.push_back(aGrid.values[iBin][3*iPoint+1]);
+	  row.push_back(aGrid.values[iBin][3*iPoint+2]);
+	}
+	aGrid.values[iBin].swap(row);
+      }
+      aGrid.sources.push_back(iSource);
+      others_.push_back(aGrid);
+    }
+    return true;
+  }
+
+  ///Uncertainties of all sources for a jet, up[iSource] and down[iSource];
+  ///-999 for jets outside of eta bins
+  void evaluate(float pt, float eta, std::vector<double> &up, std::vector<double> &down) const {
+
+    up.assign(names_.size(), 0);
+    down.assign(names_.size(), 0);
+    evaluate(shared_, pt, eta, up, down);
+    for(unsigned int iOther=0;iOther<others_.size();++iOther)
+      evaluate(others_[iOther], pt, eta, up, down);
+  }
+
+ private:
+
+  struct Grid {
+    std::vector<float> etaEdges;
+    std::vector<float> pts;
+    std::vector<std::vector<float> > values;
+    std::vector<unsigned int> sources;///indexes of sources in the table
+  };
+
+  static bool sameBinning(const Grid &a, const Grid &b) {return a.etaEdges==b.etaEdges && a.pts==b.pts;}
+
+  static void evaluate(const Grid &aGrid, float pt, float eta,
+		       std::vector<double> &up, std::vector<double> &down){
+
+    const std::vector<unsigned int> &sources = aGrid.sources;
+    if(sources.empty()) return;
+    unsigned int nSources = sources.size();
+    if(eta<aGrid.etaEdges.front() || eta>=aGrid.etaEdges.back()){
+      for(unsigned int iSource=0;iSource<nSources;++iSource){
+	up[sources[iSource]] = -999;
+	down[sources[iSource]] = -999;
+      }
+      return;
+    }
+    unsigned int iBin = std::upper_bound(aGrid.etaEdges.begin(), aGrid.etaEdges.end(), eta)-aGrid.etaEdges.begin()-1;
+
+    ///Values of the first/last point outside the points
+    const std::vector<float> &pts = aGrid.pts;
+    if(pt<=pts.front() || pt>=pts.back()){
+      const float *y = &aGrid.values[iBin][pt<=pts.front() ? 0 : 2*nSources*(pts.size()-1)];
+      for(unsigned int iSource=0;iSource<nSources;++iSource){
+	up[sources[iSource]] = y[2*iSource];
+	down[sources[iSource]] = y[2*iSource+1];
+      }
+      return;
+    }
+
+    ///Segment [iPoint,iPoint+1] containing pt
+    unsigned int iPoint = std::upper_bound(pts.begin(), pts.end(), pt)-pts.begin()-1;
+    float x1 = pts[iPoint], x2 = pts[iPoint+1];
+
+    const float *y1 = &aGrid.values[iBin][2*nSources*iPoint];
+    const float *y2 = y1+2*nSources;
+    for(unsigned int iSource=0;iSource<nSources;++iSource){
+      up[sources[iSource]] = interpolate(pt, x1, x2, y1[2*iSource], y2[2*iSource]);
+      down[sources[iSource]] = interpolate(pt, x1, x2, y1[2*iSource+1], y2[2*iSource+1]);
+    }
+  }
+
+  static float interpolate(float x, float x1, float x2, float y1, float y2){
+
+    if(x1==x2) return y1;
+    return (x*(y2-y1)+x2*y1-x1*y2)/(x2-x1);
+  }
+
+  std::vector<std::string> names_;
+
+  Grid shared_;
+  std::vector<Grid> others_;
+
+};
+
+#endif
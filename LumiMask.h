@@ -0,0 +1,138 @@
+#ifndef LumiMask_h
+#define LumiMask_h
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+#include <stdint.h>
+
+#include "BinaryStore.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Lumi blocks to be processed (e.g. from a JSON file).
+/// Ranges "run1:lumi1-run2:lumi2" are kept as intervals of
+/// run<<32|lumi keys, sorted and merged once all are added,
+/// and searched with binary search. The decision for the last
+/// lumi block is kept, as consecutive events mostly share it.
+/// An empty mask accepts all lumi blocks.
+class LumiMask{
+
+ public:
+
+  LumiMask() : sorted_(true), lastKey_(0), lastDecision_(false), hasLast_(false) {}
+
+  ~LumiMask(){}
+
+  bool empty() const {return intervals_.empty();}
+
+  unsigned int size() const {return intervals_.size();}
+
+  ///Add range in the CMSSW format "run1:lumi1-run2:lumi2" (or "run:lumi"),
+  ///throws std::invalid_argument for malformed ranges
+  void add(std::string aRange){
+
+    aRange.erase(0, aRange.find_first_not_of(" \t"));
+    aRange.erase(aRange.find_last_not_of(" \t")+1);
+    std::size_t pos = aRange.find('-');
+    uint64_t first = parseID(aRange.substr(0,pos), aRange);
+    uint64_t last = pos==std::string::npos ? first : parseID(aRange.substr(pos+1), aRange);
+    if(last<first) fail("end before begin", aRange);
+    Interval anInterval;
+    anInterval.first = first;
+    anInterval.last = last;
+    intervals_.push_back(anInterval);
+    sorted_ = false;
+    hasLast_ = false;
+  }
+
+  ///Sort and merge overlapping or adjacent ranges, to be called after all add()
+  void sort(){
+
+    if(sorted_) return;
+    std::sort(intervals_.begin(), intervals_.end());
+    std::vector<Interval> merged;
+    for(unsigned int iInterval=0;iInterval<intervals_.size();++iInterval){
+      const Interval &anInterval = intervals_[iInterval];
+      if(!merged.empty() && anInterval.first<=merged.back().last+1)
+	merged.back().last = std::max(merged.back().last, anInterval.last);
+      else merged.push_back(anInterval);
+    }
+    intervals_.swap(merged);
+    sorted_ = true;
+  }
+
+  bool contains(unsigned int run, unsigned int lumi){
+
+    if(intervals_.empty()) return true;
+    uint64_t key = makeKey(run,lumi);
+    if(hasLast_ && key==lastKey_) return lastDecision_;
+    sort();
+    ///First interval starting after the key, the one before may contain it
+    Interval aProbe;
+    aProbe.first = key;
+    aProbe.last = key;
+    std::vector<Interval>::const_iterator it = std::upper_bound(intervals_.begin(), intervals_.end(), aProbe);
+    lastDecision_ = it!=intervals_.begin() && (--it)->last>=key;
+    lastKey_ = key;
+    hasLast_ = true;
+    return lastDecision_;
+  }
+
+  ///64-bit FNV-1a hash of the merged ranges, equal for masks accepting the same lumi blocks
+  uint64_t hash(){
+
+    sort();
+    uint64_t aHash = BinaryStore::hashSeed();
+    for(unsigned int iInterval=0;iInterval<intervals_.size();++iInterval){
+      BinaryStore::hashValue(aHash, intervals_[iInterval].first);
+      BinaryStore::hashValue(aHash, intervals_[iInterval].last);
+    }
+    return aHash;
+  }
+
+ private:
+
+  struct Interval {
+    uint64_t first, last;
+    bool operator<(const Interval &other) const {return first<other.first;}
+  };
+
+  static uint64_t makeKey(unsigned int run, unsigned int lumi) {return (uint64_t(run)<<32) | lumi;}
+
+  static void fail(const std::string &reason, const std::string &aRange){
+
+    std::cout<<"[LumiMask]: Malformed lumi range \""<<aRange<<"\": "<<reason<<std::endl;
+    throw std::invalid_argument("Malformed lumi range \""+aRange+"\": "+reason);
+  }
+
+  static unsigned long parseNumber(const std::string &aText, const std::string &aRange){
+
+    if(aText.empty() || aText.find_first_not_of("0123456789")!=std::string::npos) fail("expected a number, got \""+aText+"\"", aRange);
+    errno = 0;
+    unsigned long aNumber = strtoul(aText.c_str(), NULL, 10);
+    if(errno==ERANGE || aNumber>0xFFFFFFFFUL) fail("number out of range", aRange);
+    return aNumber;
+  }
+
+  ///"run:lumi"
+  static uint64_t parseID(const std::string &aText, const std::string &aRange){
+
+    std::size_t pos = aText.find(':');
+    if(pos==std::string::npos) fail("expected run:lumi, got \""+aText+"\"", aRange);
+    return makeKey(parseNumber(aText.substr(0,pos), aRange), parseNumber(aText.substr(pos+1), aRange));
+  }
+
+  std::vector<Interval> intervals_;
+  bool sorted_;
+
+  uint64_t lastKey_;
+  bool lastDecision_, hasLast_;
+
+};
+
+#endif
@@ -1,4 +1,4 @@
-struct Parameter{
+static struct Parameter{
   float defaultValue = -10.;
   struct Datasets{
     struct DY{
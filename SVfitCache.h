@@ -0,0 +1,201 @@
+#ifndef SVfitCache_h
+#define SVfitCache_h
+
+#include <string>
+#include <map>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "SVfitWorkerPool.h"
+#include "BinaryStore.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// On-disk store of SVfit results keyed on a hash of the
+/// quantized inputs, one file per input file.
+/// The file is a header followed by records sorted in key; it is
+/// memory-mapped for lookups. New results are kept in memory and
+/// merged into the file by close().
+class SVfitCache{
+
+ public:
+
+  SVfitCache() : data_(nullptr), mapSize_(0), records_(nullptr), nRecords_(0), nHits_(0), nMisses_(0) {}
+
+  ~SVfitCache(){close();}
+
+  ///Open store, previous one is closed first. Missing or corrupted file is treated as empty.
+  void open(const std::string &fileName){
+
+    close();
+    fileName_ = fileName;
+    int fd = ::open(fileName_.c_str(), O_RDONLY);
+    if(fd<0) return;
+    struct stat fileStat;
+    if(fstat(fd, &fileStat)==0 && fileStat.st_size>=(off_t)sizeof(Header)){
+      void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(data!=MAP_FAILED){
+	const Header *aHeader = static_cast<const Header*>(data);
+	if(std::memcmp(aHeader->magic, magic(), sizeof(aHeader->magic))==0 &&
+	   (off_t)(sizeof(Header)+aHeader->nRecords*sizeof(Record))==fileStat.st_size){
+	  data_ = data;
+	  mapSize_ = fileStat.st_size;
+	  records_ = reinterpret_cast<const Record*>(static_cast<const char*>(data)+sizeof(Header));
+	  nRecords_ = aHeader->nRecords;
+	}
+	else{
+	  std::cout<<"[SVfitCache]: Ignoring incompatible file "<<fileName_<<std::endl;
+	  munmap(data, fileStat.st_size);
+	}
+      }
+    }
+    ::close(fd);
+  }
+
+  ///Write new results (if any) and release the file
+  void close(){
+
+    if(!fileName_.empty() && (nHits_ || nMisses_))
+      std::cout<<"[SVfitCache]: "<<fileName_<<": "<<nHits_<<" hits, "<<nMisses_<<" misses"<<std::endl;
+    if(!added_.empty()) write();
+    if(data_) munmap(data_, mapSize_);
+    data_ = nullptr;
+    mapSize_ = 0;
+    records_ = nullptr;
+    nRecords_ = 0;
+    nHits_ = nMisses_ = 0;
+    added_.clear();
+    fileName_.clear();
+  }
+
+  bool isOpen() const {return !fileName_.empty();}
+
+  bool find(const SVfitRequest &aRequest, SVfitResult &aResult){
+
+    uint64_t aKey = key(aRequest);
+    Record aRecord;
+    aRecord.key = aKey;
+    const Record *it = std::lower_bound(records_, records_+nRecords_, aRecord, lessKey);
+    if(it!=records_+nRecords_ && it->key==aKey){
+      toResult(*it, aResult);
+      ++nHits_;
+      return true;
+    }
+    std::map<uint64_t,Record>::const_iterator itAdded = added_.find(aKey);
+    if(itAdded!=added_.end()){
+      toResult(itAdded->second, aResult);
+      ++nHits_;
+      return true;
+    }
+    ++nMisses_;
+    return false;
+  }
+
+  void insert(const SVfitRequest &aRequest, const SVfitResult &aResult){
+
+    if(!isOpen()) return;
+    Record aRecord;
+    aRecord.key = key(aRequest);
+    aRecord.pt = aResult.pt;
+    aRecord.eta = aResult.eta;
+    aRecord.phi = aResult.phi;
+    aRecord.mass = aResult.mass;
+    aRecord.isValid = aResult.isValid;
+    added_[aRecord.key] = aRecord;
+  }
+
+  ///64-bit FNV-1a hash of inputs quantized to float precision (the precision of NanoAOD).
+  ///kappa is not hashed as it is fixed by the decay types.
+  static uint64_t key(const SVfitRequest &aRequest){
+
+    uint64_t hash = BinaryStore::hashSeed();
+    for(unsigned int iLeg=0;iLeg<2;++iLeg){
+      BinaryStore::hashValue(hash, aRequest.decayType[iLeg]);
+      BinaryStore::hashValue(hash, aRequest.decayMode[iLeg]);
+      BinaryStore::hashValue(hash, quantize(aRequest.pt[iLeg]));
+      BinaryStore::hashValue(hash, quantize(aRequest.eta[iLeg]));
+      BinaryStore::hashValue(hash, quantize(aRequest.phi[iLeg]));
+      BinaryStore::hashValue(hash, quantize(aRequest.mass[iLeg]));
+    }
+    BinaryStore::hashValue(hash, quantize(aRequest.metX));
+    BinaryStore::hashValue(hash, quantize(aRequest.metY));
+    for(unsigned int iCov=0;iCov<4;++iCov)
+      BinaryStore::hashValue(hash, quantize(aRequest.covMET[iCov]));
+    return hash;
+  }
+
+ private:
+
+  struct Header {
+    char magic[8];
+    uint64_t nRecords;
+  };
+
+  struct Record {
+    uint64_t key;
+    double pt, eta, phi, mass;
+    int64_t isValid;
+  };
+
+  ///Change the version when SVfit configuration or inputs change
+  static const char* magic() {return "SVFITC01";}
+
+  static bool lessKey(const Record &a, const Record &b) {return a.key<b.key;}
+
+  static float quantize(double x) {return (float)x;}
+
+  static void toResult(const Record &aRecord, SVfitResult &aResult){
+    aResult.pt = aRecord.pt;
+    aResult.eta = aRecord.eta;
+    aResult.phi = aRecord.phi;
+    aResult.mass = aRecord.mass;
+    aResult.isValid = aRecord.isValid;
+  }
+
+  ///Merge mapped and new records into a temporary file and move it in place
+  void write(){
+
+    BinaryStore::write(fileName_, "SVfitCache", [this](FILE *aFile){return writeRecords(aFile);});
+  }
+
+  bool writeRecords(FILE *aFile) const {
+
+    Header aHeader;
+    std::memcpy(aHeader.magic, magic(), sizeof(aHeader.magic));
+    aHeader.nRecords = 0;
+    const Record *itOld = records_, *endOld = records_+nRecords_;
+    for(std::map<uint64_t,Record>::const_iterator itNew = added_.begin();itNew!=added_.end();++itNew){
+      if(std::binary_search(itOld, endOld, itNew->second, lessKey)) continue;
+      ++aHeader.nRecords;
+    }
+    aHeader.nRecords += nRecords_;
+    bool ok = fwrite(&aHeader, sizeof(aHeader), 1, aFile)==1;
+    std::map<uint64_t,Record>::const_iterator itNew = added_.begin();
+    while(ok && (itOld!=endOld || itNew!=added_.end())){
+      if(itNew==added_.end() || (itOld!=endOld && itOld->key<=itNew->first)){
+	if(itNew!=added_.end() && itOld->key==itNew->first) ++itNew;
+	ok = fwrite(itOld++, sizeof(Record), 1, aFile)==1;
+      }
+      else ok = fwrite(&(itNew++)->second, sizeof(Record), 1, aFile)==1;
+    }
+    return ok;
+  }
+
+  std::string fileName_;
+  void *data_;
+  size_t mapSize_;
+  const Record *records_;
+  uint64_t nRecords_;
+  unsigned long nHits_, nMisses_;
+  std::map<uint64_t,Record> added_;
+
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef SVfitWorkerPool_h
+#define SVfitWorkerPool_h
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <iostream>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "TLorentzVector.h"
+#include "TMatrixD.h"
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+///Fixed-size SVfit input, can be sent to a worker as is.
+struct SVfitRequest {
+  int decayType[2];///classic_svFit::MeasuredTauLepton::kDecayType
+  int decayMode[2];
+  double pt[2], eta[2], phi[2], mass[2];
+  double metX, metY;
+  double covMET[4];///00, 01, 10, 11
+};
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+struct SVfitResult {
+  double pt, eta, phi, mass;
+  int isValid;
+};
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Pool of worker processes running SVfit asynchronously.
+/// Each worker owns its own ClassicSVfit. Processes are used
+/// instead of threads as ClassicSVfit keeps the integrand in a global
+/// pointer, so that two integrations cannot run in one process.
+/// Requests are queued by submit() and dispatched to idle workers,
+/// results are collected by ticket with get().
+class SVfitWorkerPool{
+
+ public:
+
+  SVfitWorkerPool(unsigned int nWorkers, int verbosity=0) : nextTicket_(0) {
+
+    std::cout.flush();
+    std::cerr.flush();
+    for(unsigned int iWorker=0;iWorker<nWorkers;++iWorker){
+      //socket pair instead of pipes: send() with MSG_NOSIGNAL does not raise SIGPIPE if a worker dies
+      int fds[2];
+      if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds)!=0) break;
+      pid_t pid = fork();
+      if(pid<0){
+	close(fds[0]); close(fds[1]);
+	break;
+      }
+      if(pid==0){
+	//worker: drop parent ends of all sockets so that other workers see EOF
+	for(unsigned int iOther=0;iOther<workers_.size();++iOther)
+	  close(workers_[iOther].fd);
+	close(fds[0]);
+	workerLoop(fds[1],verbosity);
+	_exit(0);
+      }
+      close(fds[1]);
+      Worker aWorker;
+      aWorker.pid = pid;
+      aWorker.fd = fds[0];
+      aWorker.busy = false;
+      aWorker.ticket = 0;
+      workers_.push_back(aWorker);
+    }
+    if(workers_.size()<nWorkers)
+      std::cout<<"[SVfitWorkerPool]: Started only "<<workers_.size()<<" of "<<nWorkers<<" workers"<<std::endl;
+  }
+
+  ~SVfitWorkerPool(){
+    for(unsigned int iWorker=0;iWorker<workers_.size();++iWorker)
+      close(workers_[iWorker].fd);
+    for(unsigned int iWorker=0;iWorker<workers_.size();++iWorker)
+      waitpid(workers_[iWorker].pid,nullptr,0);
+  }
+
+  unsigned int size() const {return workers_.size();}
+
+  ///Queue a request, returns ticket to be used with get()
+  long submit(const SVfitRequest &aRequest){
+    long ticket = nextTicket_++;
+    queue_.push_back(std::make_pair(ticket,aRequest));
+    collect(false);
+    dispatch();
+    return ticket;
+  }
+
+  ///Wait for result of a request. Returns false if the request was lost
+  ///(worker died), then it has to be recomputed by the caller.
+  bool get(long ticket, SVfitResult &aResult){
+    while(true){
+      std::map<long,SVfitResult>::iterator it = results_.find(ticket);
+      if(it!=results_.end()){
+	aResult = it->second;
+	results_.erase(it);
+	return true;
+      }
+      if(lost_.erase(ticket)) return false;
+      dispatch();
+      if(!collect(true)){//no worker left
+	for(unsigned int iQueued=0;iQueued<queue_.size();++iQueued)
+	  lost_.insert(lost_.end(),queue_[iQueued].first);
+	queue_.clear();
+      }
+    }
+  }
+
+  ///Run SVfit for a request with given algorithm
+  static void integrate(ClassicSVfit &svFitAlgo, const SVfitRequest &aRequest, SVfitResult &aResult){
+
+    std::vector<classic_svFit::MeasuredTauLepton> measuredTauLeptons;
+    for(unsigned int iLeg=0;iLeg<2;++iLeg)
+      measuredTauLeptons.push_back(classic_svFit::MeasuredTauLepton((classic_svFit::MeasuredTauLepton::kDecayType)aRequest.decayType[iLeg],
+								    aRequest.pt[iLeg], aRequest.eta[iLeg], aRequest.phi[iLeg],
+								    aRequest.mass[iLeg], aRequest.decayMode[iLeg]) );
+    TMatrixD covMET(2, 2);
+    covMET[0][0] = aRequest.covMET[0];
+    covMET[0][1] = aRequest.covMET[1];
+    covMET[1][0] = aRequest.covMET[2];
+    covMET[1][1] = aRequest.covMET[3];
+
+    //set logM regularization term which is final state dependent
+    double kappa = 4;
+    if(isLepton(aRequest.decayType[0])) { //1st tau is lepton
+      if(isLepton(aRequest.decayType[1]))
+	kappa = 3; //ll decay
+      else
+	kappa = 4; //lt decay
+    }
+    else {//1st tau is hadron
+      if(isLepton(aRequest.decayType[1]))
+	kappa = 4; //ltau decay
+      else
+	kappa = 5; //tt decay
+    }
+    svFitAlgo.addLogM_fixed(true, kappa);
+    svFitAlgo.integrate(measuredTauLeptons, aRequest.metX, aRequest.metY, covMET);
+
+    aResult.pt = aResult.eta = aResult.phi = aResult.mass = 0;
+    aResult.isValid = svFitAlgo.isValidSolution();
+    if(aResult.isValid){
+      classic_svFit::DiTauSystemHistogramAdapter* aHistogramAdapter = static_cast< classic_svFit::DiTauSystemHistogramAdapter*>(svFitAlgo.getHistogramAdapter());
+      aResult.pt = aHistogramAdapter->getPt();
+      aResult.eta = aHistogramAdapter->getEta();
+      aResult.phi = aHistogramAdapter->getPhi();
+      aResult.mass = aHistogramAdapter->getMass();
+    }
+  }
+
+  ///Configure algorithm in the same way for the main process and workers
+  static void configure(ClassicSVfit &svFitAlgo){
+    //svFitAlgo.setMaxObjFunctionCalls(100000); // CV: default is 100000 evaluations of integrand per event
+    svFitAlgo.setHistogramAdapter(new classic_svFit::DiTauSystemHistogramAdapter());//needed?
+    //svFitAlgo.setLikelihoodFileName("testClassicSVfit.root");//needed?
+    svFitAlgo.setDiTauMassConstraint(-1);//argument>0 constraints di-tau mass to its value
+  }
+
+ private:
+
+  struct Worker {
+    pid_t pid;
+    int fd;
+    bool busy;
+    long ticket;
+  };
+
+  static bool isLepton(int decayType){
+    return decayType==classic_svFit::MeasuredTauLepton::kTauToElecDecay ||
+      decayType==classic_svFit::MeasuredTauLepton::kTauToMuDecay;
+  }
+
+  static bool writeAll(int fd, const void *buffer, size_t size){
+    const char *data = static_cast<const char*>(buffer);
+    while(size>0){
+      ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+      if(n<0 && errno==EINTR) continue;
+      if(n<=0) return false;
+      data += n; size -= n;
+    }
+    return true;
+  }
+
+  static bool readAll(int fd, void *buffer, size_t size){
+    char *data = static_cast<char*>(buffer);
+    while(size>0){
+      ssize_t n = read(fd, data, size);
+      if(n<0 && errno==EINTR) continue;
+      if(n<=0) return false;
+      data += n; size -= n;
+    }
+    return true;
+  }
+
+  static void workerLoop(int fd, int verbosity){
+    ClassicSVfit svFitAlgo(verbosity);
+    configure(svFitAlgo);
+    SVfitRequest aRequest;
+    SVfitResult aResult;
+    while(readAll(fd, &aRequest, sizeof(aRequest))){
+      integrate(svFitAlgo, aRequest, aResult);
+      if(!writeAll(fd, &aResult, sizeof(aResult))) break;
+    }
+    close(fd);
+  }
+
+  ///Send queued requests to idle workers
+  void dispatch(){
+    for(unsigned int iWorker=0;iWorker<workers_.size() && !queue_.empty();++iWorker){
+      Worker &aWorker = workers_[iWorker];
+      if(aWorker.busy) continue;
+      if(!writeAll(aWorker.fd, &queue_.front().second, sizeof(SVfitRequest))){
+	removeWorker(iWorker--);
+	continue;
+      }
+      aWorker.busy = true;
+      aWorker.ticket = queue_.front().first;
+      queue_.pop_front();
+    }
+  }
+
+  ///Read results of finished workers, if wait is set block until at least one is ready.
+  ///Returns false if there is no worker left.
+  bool collect(bool wait){
+    if(workers_.empty()) return false;
+    std::vector<pollfd> fds(workers_.size());
+    bool anyBusy = false;
+    for(unsigned int iWorker=0;iWorker<workers_.size();++iWorker){
+      fds[iWorker].fd = workers_[iWorker].fd;
+      fds[iWorker].events = POLLIN;
+      fds[iWorker].revents = 0;
+      anyBusy |= workers_[iWorker].busy;
+    }
+    if(!anyBusy) return true;
+    int nReady = poll(&fds[0], fds.size(), wait ? -1 : 0);
+    if(nReady<=0) return true;
+    for(int iWorker=workers_.size()-1;iWorker>=0;--iWorker){
+      if(!fds[iWorker].revents) continue;
+      Worker &aWorker = workers_[iWorker];
+      SVfitResult aResult;
+      if(!aWorker.busy || !readAll(aWorker.fd, &aResult, sizeof(aResult))){
+	removeWorker(iWorker);
+	continue;
+      }
+      results_[aWorker.ticket] = aResult;
+      aWorker.busy = false;
+    }
+    return !workers_.empty();
+  }
+
+  void removeWorker(unsigned int iWorker){
+    Worker &aWorker = workers_[iWorker];
+    std::cout<<"[SVfitWorkerPool]: Worker "<<aWorker.pid<<" stopped responding, removing it"<<std::endl;
+    if(aWorker.busy) lost_.insert(lost_.end(),aWorker.ticket);
+    close(aWorker.fd);
+    waitpid(aWorker.pid,nullptr,0);
+    workers_.erase(workers_.begin()+iWorker);
+  }
+
+  std::vector<Worker> workers_;
+  std::deque<std::pair<long,SVfitRequest> > queue_;
+  std::map<long,SVfitResult> results_;
+  std::set<long> lost_;
+  long nextTicket_;
+
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SkimIndex_h
+#define SkimIndex_h
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#include "BinaryStore.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Sorted list of entries of one input file, stored as a
+/// sidecar file next to other runs' results: a header with the
+/// hash of the selection configuration and the number of entries
+/// of the input file, followed by the entries.
+/// The hash is made with BinaryStore::hashValue().
+/// A list is valid only for the same configuration and input,
+/// read() rejects others. selects() walks the list with a cursor,
+/// for entries asked in increasing order.
+class SkimIndex{
+
+ public:
+
+  SkimIndex() : cursor_(0) {}
+
+  ~SkimIndex(){}
+
+  void clear(){
+    entries_.clear();
+    cursor_ = 0;
+  }
+
+  unsigned int size() const {return entries_.size();}
+
+  const std::vector<int64_t> & entries() const {return entries_;}
+
+  void add(int64_t entry) {entries_.push_back(entry);}
+
+  void add(const SkimIndex &other) {entries_.insert(entries_.end(), other.entries_.begin(), other.entries_.end());}
+
+  ///Sort and remove duplicates, to be called after add() of other lists
+  void sort(){
+    std::sort(entries_.begin(), entries_.end());
+    entries_.erase(std::unique(entries_.begin(), entries_.end()), entries_.end());
+    cursor_ = 0;
+  }
+
+  ///True if entry is in the list; entries have to be asked in increasing order
+  bool selects(int64_t entry){
+    while(cursor_<entries_.size() && entries_[cursor_]<entry) ++cursor_;
+    return cursor_<entries_.size() && entries_[cursor_]==entry;
+  }
+
+  ///Read list, false if the file is missing, corrupted or made for another configuration or input
+  bool read(const std::string &fileName, uint64_t configHash, uint64_t fileEntries){
+
+    clear();
+    FILE *aFile = fopen(fileName.c_str(), "rb");
+    if(!aFile) return false;
+    Header aHeader;
+    bool ok = fread(&aHeader, sizeof(aHeader), 1, aFile)==1 &&
+      std::memcmp(aHeader.magic, magic(), sizeof(aHeader.magic))==0 &&
+      aHeader.configHash==configHash && aHeader.fileEntries==fileEntries &&
+      aHeader.nEntries<=fileEntries;
+    if(ok){
+      entries_.resize(aHeader.nEntries);
+      ok = aHeader.nEntries==0 || fread(entries_.data(), sizeof(int64_t), aHeader.nEntries, aFile)==aHeader.nEntries;
+      ok &= fgetc(aFile)==EOF;
+    }
+    fclose(aFile);
+    if(!ok){
+      std::cout<<"[SkimIndex]: Ignoring incompatible file "<<fileName<<std::endl;
+      clear();
+    }
+    return ok;
+  }
+
+  ///Write sorted list into a temporary file and move it in place
+  bool write(const std::string &fileName, uint64_t configHash, uint64_t fileEntries){
+
+    sort();
+    Header aHeader;
+    std::memcpy(aHeader.magic, magic(), sizeof(aHeader.magic));
+    aHeader.configHash = configHash;
+    aHeader.fileEntries = fileEntries;
+    aHeader.nEntries = entries_.size();
+    return BinaryStore::write(fileName, "SkimIndex", [&](FILE *aFile){
+	return fwrite(&aHeader, sizeof(aHeader), 1, aFile)==1 &&
+	  (entries_.empty() || fwrite(entries_.data(), sizeof(int64_t), entries_.size(), aFile)==entries_.size());
+      });
+  }
+
+ private:
+
+  struct Header {
+    char magic[8];
+    uint64_t configHash;
+    uint64_t fileEntries;
+    uint64_t nEntries;
+  };
+
+  ///Change the version when the file format changes
+  static const char* magic() {return "SKIMIX01";}
+
+  std::vector<int64_t> entries_;
+  size_t cursor_;
+
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef StageTimer_h
+#define StageTimer_h
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <time.h>
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Cumulative wall time, CPU time of the calling thread
+/// and number of calls of named stages of a loop.
+/// A stage is timed by a Scope living for its duration;
+/// a disabled timer (or none) only costs a check of a flag.
+/// Times of timers used by other threads are summed with
+/// add(), so the wall time of a stage is also summed over
+/// threads and can exceed the wall time of the loop.
+class StageTimer{
+
+ public:
+
+  StageTimer(const std::vector<std::string> &names) : names_(names), enabled_(false) {reset();}
+
+  ~StageTimer(){}
+
+  void enable(bool enabled) {enabled_ = enabled;}
+
+  bool enabled() const {return enabled_;}
+
+  unsigned int size() const {return names_.size();}
+
+  const std::string & name(unsigned int iStage) const {return names_[iStage];}
+
+  unsigned long long calls(unsigned int iStage) const {return calls_[iStage];}
+
+  ///Seconds
+  double wallTime(unsigned int iStage) const {return wallTime_[iStage];}
+
+  double cpuTime(unsigned int iStage) const {return cpuTime_[iStage];}
+
+  void reset(){
+
+    calls_.assign(names_.size(), 0);
+    wallTime_.assign(names_.size(), 0);
+    cpuTime_.assign(names_.size(), 0);
+  }
+
+  ///Add times of other timer with the same stages
+  void add(const StageTimer &other){
+
+    for(unsigned int iStage=0;iStage<names_.size() && iStage<other.size();++iStage){
+      calls_[iStage] += other.calls_[iStage];
+      wallTime_[iStage] += other.wallTime_[iStage];
+      cpuTime_[iStage] += other.cpuTime_[iStage];
+    }
+  }
+
+  ///Stages which were called, with their share of the total CPU time
+  void print(const std::string &title) const {
+
+    double totalCpu = 0;
+    for(unsigned int iStage=0;iStage<names_.size();++iStage) totalCpu += cpuTime_[iStage];
+    std::cout<<"[StageTimer]: "<<title<<std::endl;
+    char line[256];
+    snprintf(line, sizeof(line), "%-28s %12s %12s %12s %10s %7s",
+	     "stage", "calls", "wall [s]", "cpu [s]", "cpu/call", "cpu %");
+    std::cout<<"\t"<<line<<std::endl;
+    for(unsigned int iStage=0;iStage<names_.size();++iStage){
+      if(calls_[iStage]==0) continue;
+      snprintf(line, sizeof(line), "%-28s %12llu %12.3f %12.3f %8.2fus %6.1f%%",
+	       names_[iStage].c_str(), calls_[iStage], wallTime_[iStage], cpuTime_[iStage],
+	       1E6*cpuTime_[iStage]/calls_[iStage], totalCpu>0 ? 100*cpuTime_[iStage]/totalCpu : 0.);
+      std::cout<<"\t"<<line<<std::endl;
+    }
+  }
+
+  ///Times the given stage from construction to destruction
+  class Scope{
+
+  public:
+
+    Scope(StageTimer *aTimer, unsigned int iStage) :
+      timer_(aTimer!=nullptr && aTimer->enabled_ ? aTimer : nullptr), iStage_(iStage) {
+      if(timer_==nullptr) return;
+      wallStart_ = std::chrono::steady_clock::now();
+      cpuStart_ = threadCpuTime();
+    }
+
+    ~Scope(){
+      if(timer_==nullptr) return;
+      timer_->cpuTime_[iStage_] += threadCpuTime()-cpuStart_;
+      timer_->wallTime_[iStage_] += std::chrono::duration<double>(std::chrono::steady_clock::now()-wallStart_).count();
+      ++timer_->calls_[iStage_];
+    }
+
+  private:
+
+    Scope(const Scope &);
+    Scope & operator=(const Scope &);
+
+    StageTimer *timer_;
+    unsigned int iStage_;
+    std::chrono::steady_clock::time_point wallStart_;
+    double cpuStart_;
+  };
+
+ private:
+
+  static double threadCpuTime(){
+
+    timespec aTime;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &aTime)!=0) return 0;
+    return aTime.tv_sec+1E-9*aTime.tv_nsec;
+  }
+
+  std::vector<std::string> names_;
+  std::vector<unsigned long long> calls_;
+  std::vector<double> wallTime_, cpuTime_;
+  bool enabled_;
+
+};
+
+#endif
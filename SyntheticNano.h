@@ -0,0 +1,396 @@
+#ifndef SyntheticNano_h
+#define SyntheticNano_h
+
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <iostream>
+
+#include "TClass.h"
+#include "TDataMember.h"
+#include "TDataType.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TRandom3.h"
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Writer of synthetic Events trees with the schema of
+/// NanoEventsSkeleton, taken from its dictionary, so that it
+/// follows the skeleton when it is regenerated. Multiplicities
+/// of the main collections are Poisson distributed around the
+/// configured means, capped by the array sizes of the skeleton.
+/// Values are drawn with rough physical shapes guessed from the
+/// branch names; trigger objects are placed on the leptons so
+/// that trigger matching and pair selection are exercised.
+/// In data mode generator level branches are not written.
+class SyntheticNano{
+
+ public:
+
+  struct Config {
+    Long64_t nEvents;
+    double nMuon, nElectron, nTau, nJet, nGenPart, nTrigObj;
+    bool isData;
+    unsigned int seed;
+    Config() : nEvents(10000), nMuon(1.5), nElectron(1.5), nTau(2), nJet(5),
+	       nGenPart(40), nTrigObj(8), isData(false), seed(4357) {}
+  };
+
+  SyntheticNano(const Config &aConfig) : config_(aConfig), random_(aConfig.seed) {}
+
+  ~SyntheticNano(){}
+
+  ///Write Events tree to a new file, false if the schema is not available
+  bool write(const std::string &fileName){
+
+    if(!buildFields()) return false;
+    TFile aFile(fileName.c_str(), "RECREATE");
+    if(aFile.IsZombie()) return false;
+    TTree *aTree = new TTree("Events", "Synthetic NanoAOD events");
+    ///Counters first, leaf lists of arrays refer to them
+    for(unsigned int pass=0;pass<2;++pass){
+      for(unsigned int iField=0;iField<fields_.size();++iField){
+	Field &aField = fields_[iField];
+	if(aField.isCounter!=(pass==0)) continue;
+	std::string leafList = aField.name;
+	if(!aField.counter.empty()) leafList += "["+aField.counter+"]";
+	leafList += std::string("/")+aField.code;
+	aTree->Branch(aField.name.c_str(), &aField.buffer[0], leafList.c_str());
+      }
+    }
+    for(iEvent_=0;iEvent_<config_.nEvents;++iEvent_){
+      fillEvent();
+      aTree->Fill();
+    }
+    aFile.Write();
+    std::cout<<"[SyntheticNano]: Written "<<config_.nEvents<<(config_.isData ? " data" : " MC")
+	     <<" events with "<<fields_.size()<<" branches to "<<fileName<<std::endl;
+    return true;
+  }
+
+ private:
+
+  struct Field {
+    std::string name, collection, attribute, counter;
+    EDataType type;
+    char code;
+    unsigned int size, maxIndex;
+    bool isCounter;
+    int iCounter;///index of counter field, -1 for scalars
+    std::vector<char> buffer;
+  };
+
+  static char leafCode(EDataType type){
+
+    switch(type){
+    case kFloat_t: return 'F';
+    case kDouble_t: return 'D';
+    case kInt_t: return 'I';
+    case kUInt_t: return 'i';
+    case kChar_t: return 'B';
+    case kUChar_t: return 'b';
+    case kBool_t: return 'O';
+    case kShort_t: return 'S';
+    case kUShort_t: return 's';
+    case kLong64_t: case kLong_t: return 'L';
+    case kULong64_t: case kULong_t: return 'l';
+    default: return 0;
+    }
+  }
+
+  ///Generator level content is missing in data
+  static bool isMCOnly(const std::string &name){
+
+    const char *prefixes[] = {"Gen", "nGen", "gen", "LHE", "nLHE", "Pileup_", "Generator_"};
+    for(unsigned int iPrefix=0;iPrefix<sizeof(prefixes)/sizeof(prefixes[0]);++iPrefix)
+      if(name.compare(0, strlen(prefixes[iPrefix]), prefixes[iPrefix])==0) return true;
+    return name.find("_genPart")!=std::string::npos || name.find("_genJet")!=std::string::npos;
+  }
+
+  bool buildFields(){
+
+    fields_.clear();
+    fieldIndex_.clear();
+    maxCounts_.clear();
+    TClass *aClass = TClass::GetClass("NanoEventsSkeleton");
+    if(aClass==nullptr || aClass->GetListOfDataMembers()==nullptr){
+      std::cout<<"[SyntheticNano]: No dictionary of NanoEventsSkeleton, cannot build the schema"<<std::endl;
+      return false;
+    }
+    TIter next(aClass->GetListOfDataMembers());
+    while(TDataMember *aMember = (TDataMember*)next()){
+      if(aMember->IsaPointer() || !aMember->IsBasic() || aMember->GetDataType()==nullptr) continue;
+      Field aField;
+      aField.name = aMember->GetName();
+      if(aField.name=="fCurrent") continue;
+      if(config_.isData && isMCOnly(aField.name)) continue;
+      aField.type = (EDataType)aMember->GetDataType()->GetType();
+      aField.code = leafCode(aField.type);
+      if(aField.code==0) continue;
+      aField.size = aMember->GetDataType()->Size();
+      aField.maxIndex = aMember->GetArrayDim()>0 ? aMember->GetMaxIndex(0) : 1;
+      ///Counter from comment "[nX]" of MakeClass
+      std::string title = aMember->GetTitle();
+      if(aMember->GetArrayDim()>0 && title.size()>2 && title[0]=='[')
+	aField.counter = title.substr(1, title.find(']')-1);
+      std::size_t pos = aField.name.find('_');
+      aField.collection = aMember->GetArrayDim()>0 ? aField.name.substr(0,pos) : "";
+      aField.attribute = pos==std::string::npos ? aField.name : aField.name.substr(pos+1);
+      aField.isCounter = false;
+      aField.iCounter = -1;
+      aField.buffer.assign(aField.size*aField.maxIndex, 0);
+      fieldIndex_[aField.name] = fields_.size();
+      fields_.push_back(aField);
+    }
+    for(unsigned int iField=0;iField<fields_.size();++iField){
+      Field &aField = fields_[iField];
+      ///Without comments in the dictionary arrays of collection X are counted by nX
+      if(aField.counter.empty() && !aField.collection.empty()) aField.counter = "n"+aField.collection;
+      if(aField.counter.empty()) continue;
+      std::map<std::string,unsigned int>::const_iterator it = fieldIndex_.find(aField.counter);
+      if(it==fieldIndex_.end()){
+	std::cout<<"[SyntheticNano]: Counter "<<aField.counter<<" of "<<aField.name<<" not found"<<std::endl;
+	return false;
+      }
+      aField.iCounter = it->second;
+      fields_[it->second].isCounter = true;
+      ///Largest size of arrays sharing the counter
+      unsigned int &maxCount = maxCounts_[aField.counter];
+      maxCount = maxCount==0 ? aField.maxIndex : std::min(maxCount, aField.maxIndex);
+    }
+    return !fields_.empty();
+  }
+
+  template<typename T> static void store(Field &aField, unsigned int index, T value){
+    memcpy(&aField.buffer[index*aField.size], &value, sizeof(T));
+  }
+
+  static void set(Field &aField, unsigned int index, double value){
+
+    switch(aField.type){
+    case kFloat_t: store<Float_t>(aField, index, value); break;
+    case kDouble_t: store<Double_t>(aField, index, value); break;
+    case kInt_t: store<Int_t>(aField, index, std::lround(value)); break;
+    case kUInt_t: store<UInt_t>(aField, index, std::lround(value)); break;
+    case kChar_t: store<Char_t>(aField, index, std::lround(value)); break;
+    case kUChar_t: store<UChar_t>(aField, index, std::lround(value)); break;
+    case kBool_t: store<Bool_t>(aField, index, value!=0); break;
+    case kShort_t: store<Short_t>(aField, index, std::lround(value)); break;
+    case kUShort_t: store<UShort_t>(aField, index, std::lround(value)); break;
+    case kLong64_t: case kLong_t: store<Long64_t>(aField, index, std::llround(value)); break;
+    case kULong64_t: case kULong_t: store<ULong64_t>(aField, index, std::llround(value)); break;
+    default: break;
+    }
+  }
+
+  double get(const std::string &name, unsigned int index) const {
+
+    std::map<std::string,unsigned int>::const_iterator it = fieldIndex_.find(name);
+    if(it==fieldIndex_.end()) return 0;
+    const Field &aField = fields_[it->second];
+    if(index>=aField.maxIndex) return 0;
+    const char *data = &aField.buffer[index*aField.size];
+    switch(aField.type){
+    case kFloat_t: {Float_t value; memcpy(&value, data, sizeof(value)); return value;}
+    case kInt_t: {Int_t value; memcpy(&value, data, sizeof(value)); return value;}
+    default: return 0;
+    }
+  }
+
+  unsigned int count(const std::string &collection) const {
+
+    std::map<std::string,unsigned int>::const_iterator it = fieldIndex_.find("n"+collection);
+    if(it==fieldIndex_.end()) return 0;
+    UInt_t value = 0;
+    memcpy(&value, &fields_[it->second].buffer[0], sizeof(value));
+    return value;
+  }
+
+  double meanCount(const std::string &counter) const {
+
+    if(counter=="nMuon") return config_.nMuon;
+    if(counter=="nElectron") return config_.nElectron;
+    if(counter=="nTau") return config_.nTau;
+    if(counter=="nJet") return config_.nJet;
+    if(counter=="nGenPart") return config_.nGenPart;
+    if(counter=="nTrigObj") return config_.nTrigObj;
+    return 2;
+  }
+
+  ///Sign of charge of object of a collection, same for all its branches in the event
+  int sign(const std::string &collection, unsigned int index) const {
+
+    unsigned int shift = (index+7*collection.size()+collection[0])%64;
+    return (signBits_>>shift)&1 ? 1 : -1;
+  }
+
+  ///Bit mask of lowest n bits with random n
+  double bitMask(unsigned int maxBits) {return (1<<random_.Integer(maxBits+1))-1;}
+
+  void fillEvent(){
+
+    signBits_ = (ULong64_t(random_.Integer(0xFFFFFFFF))<<32) | random_.Integer(0xFFFFFFFF);
+    ///Counters, the one of trigger objects after leptons
+    for(unsigned int pass=0;pass<2;++pass){
+      for(unsigned int iField=0;iField<fields_.size();++iField){
+	Field &aField = fields_[iField];
+	if(!aField.isCounter || (aField.name=="nTrigObj")!=(pass==1)) continue;
+	unsigned int maxCount = maxCounts_[aField.name];
+	unsigned int aCount = aField.name=="nLHEPdfWeight" || aField.name=="nLHEScaleWeight" ? maxCount
+	  : random_.Poisson(meanCount(aField.name));
+	if(pass==1) aCount = std::max(aCount, count("Muon")+count("Electron")+count("Tau"));
+	set(aField, 0, std::min(aCount, maxCount));
+      }
+    }
+    ///Trigger objects last, they copy leptons
+    for(unsigned int pass=0;pass<2;++pass){
+      for(unsigned int iField=0;iField<fields_.size();++iField){
+	Field &aField = fields_[iField];
+	if(aField.isCounter || (aField.collection=="TrigObj")!=(pass==1)) continue;
+	if(aField.iCounter<0){
+	  set(aField, 0, scalarValue(aField));
+	  continue;
+	}
+	unsigned int aCount = 0;
+	memcpy(&aCount, &fields_[aField.iCounter].buffer[0], sizeof(aCount));
+	for(unsigned int index=0;index<aCount;++index)
+	  set(aField, index, pass==1 ? trigObjValue(aField, index) : arrayValue(aField, index));
+      }
+    }
+  }
+
+  double scalarValue(const Field &aField){
+
+    const std::string &name = aField.name;
+    const std::string &attribute = aField.attribute;
+    if(name=="run") return config_.isData ? 273158+iEvent_/100000 : 1;
+    if(name=="luminosityBlock") return 1+iEvent_/500;
+    if(name=="event") return iEvent_+1;
+    if(name=="genWeight" || name.find("LHEWeight")==0) return 1;
+    if(name.find("HLT_")==0) return random_.Rndm()<0.8;
+    if(name.find("Flag_")==0) return random_.Rndm()<0.99;
+    if(name.find("L1_")==0) return random_.Rndm()<0.5;
+    if(attribute=="phi") return random_.Uniform(-M_PI, M_PI);
+    if(attribute=="pt" || attribute=="HT" || attribute=="Vpt") return random_.Exp(30);
+    if(attribute=="sumEt") return random_.Uniform(500, 2000);
+    if(attribute=="covXX" || attribute=="covYY") return random_.Uniform(200, 600);
+    if(attribute=="covXY") return random_.Gaus(0, 50);
+    if(name.find("fixedGridRho")==0) return random_.Uniform(5, 30);
+    if(name=="PV_x" || name=="PV_y") return random_.Gaus(0, 0.01);
+    if(name=="PV_z") return random_.Gaus(0, 5);
+    if(name.find("PV_npvs")==0 || name.find("Pileup_n")==0) return random_.Poisson(20);
+    if(aField.code=='O') return random_.Rndm()<0.8;
+    if(aField.code=='F' || aField.code=='D') return random_.Rndm();
+    return random_.Integer(5);
+  }
+
+  double arrayValue(const Field &aField, unsigned int index){
+
+    const std::string &collection = aField.collection;
+    const std::string &attribute = aField.attribute;
+    bool isJet = collection.find("Jet")!=std::string::npos;
+    if(attribute=="pt"){
+      if(collection=="GenPart") return random_.Exp(30);
+      return (isJet ? 20+random_.Exp(40) : 20+random_.Exp(25));
+    }
+    if(attribute=="eta") return random_.Uniform(isJet ? -4.7 : -2.4, isJet ? 4.7 : 2.4);
+    if(attribute=="phi") return random_.Uniform(-M_PI, M_PI);
+    if(attribute=="mass"){
+      if(collection=="Muon") return 0.1057;
+      if(collection=="Electron") return 0.000511;
+      if(collection=="Tau") return random_.Uniform(0.2, 1.5);
+      if(isJet) return random_.Uniform(5, 25);
+      return 0;
+    }
+    if(attribute=="charge") return sign(collection, index);
+    if(attribute=="pdgId"){
+      if(collection=="Muon") return -13*sign(collection, index);
+      if(collection=="Electron") return -11*sign(collection, index);
+      if(collection=="GenPart"){
+	if(index==0) return 25;
+	if(index<3) return index==1 ? 15 : -15;
+	const int ids[] = {211, -211, 111, 22, 16, -16, 13, -13, 11, -11, 15, -15};
+	return ids[random_.Integer(sizeof(ids)/sizeof(ids[0]))];
+      }
+      return random_.Integer(2) ? 1 : 21;
+    }
+    if(attribute=="genPartIdxMother"){
+      if(collection!="GenPart") return count("GenPart") ? (int)random_.Integer(count("GenPart")) : -1;
+      if(index==0) return -1;
+      return index<3 ? 0 : (int)random_.Integer(index);
+    }
+    std::size_t posIdx = attribute.find("Idx");
+    if(posIdx!=std::string::npos){
+      std::string target = attribute.substr(0,posIdx);
+      if(!target.empty()) target[0] = toupper(target[0]);
+      unsigned int nTarget = count(target);
+      return nTarget && random_.Rndm()<0.7 ? (int)random_.Integer(nTarget) : -1;
+    }
+    if(attribute=="status") return random_.Integer(2) ? 1 : 2;
+    if(attribute=="statusFlags") return random_.Integer(1<<15);
+    if(attribute=="decayMode"){
+      const int modes[] = {0, 1, 10};
+      return modes[random_.Integer(3)];
+    }
+    if(attribute=="eCorr") return random_.Gaus(1, 0.02);
+    if(attribute=="dxy" || attribute=="dz") return random_.Gaus(0, 0.005);
+    if(attribute.find("Err")!=std::string::npos) return random_.Exp(0.001);
+    if(attribute=="leadTkPtOverTauPt") return random_.Uniform(0.3, 1);
+    if(attribute.find("leadTkDelta")==0) return random_.Gaus(0, 0.01);
+    if(attribute.find("raw")==0 && aField.code=='F') return attribute=="rawFactor" ? random_.Uniform(0, 0.3) : random_.Uniform(-1, 1);
+    if(attribute.find("Iso")!=std::string::npos || attribute.find("iso")!=std::string::npos) return random_.Exp(0.1);
+    if(attribute=="jetId") return bitMask(3);
+    if(attribute=="cutBased") return random_.Integer(5);
+    if(attribute.find("id")==0 && aField.code!='O') return bitMask(7);
+    if(aField.code=='O') return random_.Rndm()<0.8;
+    if(aField.code=='F' || aField.code=='D') return random_.Rndm();
+    return random_.Integer(8);
+  }
+
+  ///Trigger objects on leptons first: muons, electrons, taus
+  double trigObjValue(const Field &aField, unsigned int index){
+
+    const char *collections[] = {"Muon", "Electron", "Tau"};
+    const int ids[] = {13, 11, 15};
+    unsigned int offset = 0;
+    for(unsigned int iCol=0;iCol<3;++iCol){
+      unsigned int nLeptons = count(collections[iCol]);
+      if(index<offset+nLeptons){
+	std::string collection = collections[iCol];
+	unsigned int iLepton = index-offset;
+	const std::string &attribute = aField.attribute;
+	if(attribute=="id") return ids[iCol];
+	if(attribute=="pt" || attribute=="l1pt" || attribute=="l1pt_2" || attribute=="l2pt")
+	  return get(collection+"_pt", iLepton)*random_.Uniform(0.95, 1.05);
+	if(attribute=="eta") return get(collection+"_eta", iLepton)+random_.Gaus(0, 0.01);
+	if(attribute=="phi") return get(collection+"_phi", iLepton)+random_.Gaus(0, 0.01);
+	if(attribute=="filterBits") return 0xFFFF;
+	if(attribute=="l1charge") return get(collection+"_charge", iLepton);
+	return 1;
+      }
+      offset += nLeptons;
+    }
+    if(aField.attribute=="id"){
+      const int otherIds[] = {1, 2, 3, 6, 22};
+      return otherIds[random_.Integer(5)];
+    }
+    if(aField.attribute=="filterBits") return random_.Integer(1<<15);
+    return arrayValue(aField, index);
+  }
+
+  Config config_;
+  TRandom3 random_;
+  std::vector<Field> fields_;
+  std::map<std::string,unsigned int> fieldIndex_;
+  std::map<std::string,unsigned int> maxCounts_;
+  Long64_t iEvent_;
+  ULong64_t signBits_;
+
+};
+
+#endif
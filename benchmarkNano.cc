@@ -0,0 +1,227 @@
+/*****************************
+* Throughput benchmark of the conversion on synthetic NanoAOD
+* events (see SyntheticNano.h), runs offline without CMS inputs.
+* Each channel is converted in its own process, so that its
+* peak memory is measured alone.
+*****************************/
+
+#include "HMuTauhTreeFromNano.h"
+#include "HElTauhTreeFromNano.h"
+#include "HTauhTauhTreeFromNano.h"
+#include "SyntheticNano.h"
+
+#include <TFile.h>
+#include <TChain.h>
+#include <TSystem.h>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+void usage(const char *name){
+
+  std::cout<<"Usage: "<<name<<" [options]"<<std::endl
+	   <<"  -n, --nevents N          synthetic events (default: 20000)"<<std::endl
+	   <<"      --muons X            mean multiplicities of collections (defaults: 1.5, 1.5, 2, 5, 40, 8)"<<std::endl
+	   <<"      --electrons X"<<std::endl
+	   <<"      --taus X"<<std::endl
+	   <<"      --jets X"<<std::endl
+	   <<"      --genparts X"<<std::endl
+	   <<"      --trigobjs X"<<std::endl
+	   <<"      --data               data events, without generator level content"<<std::endl
+	   <<"      --seed N             seed of the generator"<<std::endl
+	   <<"  -i, --input FILE         benchmark on an existing file instead of synthetic events"<<std::endl
+	   <<"  -c, --channel mt|et|tt|all|each  channel(s) converted in one run, each: mt, et, tt and all one by one (default)"<<std::endl
+	   <<"  -j, --threads N          conversion threads"<<std::endl
+	   <<"  -s, --svfit              compute SVfit"<<std::endl
+	   <<"  -r, --recoil             apply MET recoil corrections"<<std::endl
+	   <<"  -t, --timing             time stages of the event loop"<<std::endl
+	   <<"  -k, --keep               keep synthetic input and outputs"<<std::endl;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+struct BenchmarkResult {
+  Long64_t entries;
+  double wallTime, cpuTime;
+  Long64_t bytesRead;
+  long peakRSS;///kB
+};
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+std::vector<HTauTauTreeFromNanoBase*> makeConverters(const std::string &channel, TChain *aChain,
+						     bool doSvFit, bool applyRecoil){
+
+  std::vector<HTauTauTreeFromNanoBase*> converters;
+  if(channel=="mt" || channel=="all") converters.push_back(new HMuTauhTreeFromNano(aChain,doSvFit,applyRecoil));
+  if(channel=="et" || channel=="all") converters.push_back(new HElTauhTreeFromNano(aChain,doSvFit,applyRecoil));
+  if(channel=="tt" || channel=="all") converters.push_back(new HTauhTauhTreeFromNano(aChain,doSvFit,applyRecoil));
+  return converters;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+///Convert in this process, to be called in a child process
+BenchmarkResult runChannel(const std::string &fileName, const std::string &channel, unsigned int nThreads,
+			   bool doSvFit, bool applyRecoil, bool stageTimes){
+
+  BenchmarkResult aResult = {0, 0, 0, 0, 0};
+  TChain *aChain = new TChain("Events");
+  aChain->Add(fileName.c_str());
+  aResult.entries = aChain->GetEntries();
+  if(aChain->LoadTree(0)<0) return aResult;
+
+  std::vector<HTauTauTreeFromNanoBase*> converters = makeConverters(channel, aChain, doSvFit, applyRecoil);
+  for(unsigned int iConverter=1;iConverter<converters.size();++iConverter)
+    converters[0]->addChannel(converters[iConverter]);
+  converters[0]->setLoopThreads(nThreads);
+  converters[0]->setStageTimes(stageTimes);
+
+  Long64_t bytesBefore = TFile::GetFileBytesRead();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  converters[0]->Loop(-1,0);
+  aResult.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  aResult.bytesRead = TFile::GetFileBytesRead()-bytesBefore;
+
+  for(unsigned int iConverter=0;iConverter<converters.size();++iConverter){
+    converters[iConverter]->fChain = nullptr;
+    delete converters[iConverter];
+  }
+  delete aChain;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  aResult.cpuTime = usage.ru_utime.tv_sec+1E-6*usage.ru_utime.tv_usec+usage.ru_stime.tv_sec+1E-6*usage.ru_stime.tv_usec;
+  aResult.peakRSS = usage.ru_maxrss;
+  return aResult;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+///Convert in a child process, false if it failed
+bool forkChannel(const std::string &fileName, const std::string &channel, unsigned int nThreads,
+		 bool doSvFit, bool applyRecoil, bool stageTimes, BenchmarkResult &aResult){
+
+  int fds[2];
+  if(pipe(fds)!=0) return false;
+  std::cout.flush();
+  pid_t pid = fork();
+  if(pid<0) return false;
+  if(pid==0){
+    close(fds[0]);
+    BenchmarkResult childResult = runChannel(fileName, channel, nThreads, doSvFit, applyRecoil, stageTimes);
+    std::cout.flush();
+    ssize_t nBytes = write(fds[1], &childResult, sizeof(childResult));
+    _exit(nBytes==sizeof(childResult) ? 0 : 1);
+  }
+  close(fds[1]);
+  ssize_t nBytes = read(fds[0], &aResult, sizeof(aResult));
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return nBytes==sizeof(aResult) && WIFEXITED(status) && WEXITSTATUS(status)==0;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+  SyntheticNano::Config aConfig;
+  aConfig.nEvents = 20000;
+  std::string inputFile;
+  std::string channel = "each";
+  unsigned int nThreads = 1;
+  bool doSvFit = false, applyRecoil = false, stageTimes = false, keep = false;
+
+  for(int iArg=1;iArg<argc;++iArg){
+    std::string arg = argv[iArg];
+    bool hasValue = iArg+1<argc;
+    if(arg=="-h" || arg=="--help"){ usage(argv[0]); return 0; }
+    else if((arg=="-n" || arg=="--nevents") && hasValue) aConfig.nEvents = atoll(argv[++iArg]);
+    else if(arg=="--muons" && hasValue) aConfig.nMuon = atof(argv[++iArg]);
+    else if(arg=="--electrons" && hasValue) aConfig.nElectron = atof(argv[++iArg]);
+    else if(arg=="--taus" && hasValue) aConfig.nTau = atof(argv[++iArg]);
+    else if(arg=="--jets" && hasValue) aConfig.nJet = atof(argv[++iArg]);
+    else if(arg=="--genparts" && hasValue) aConfig.nGenPart = atof(argv[++iArg]);
+    else if(arg=="--trigobjs" && hasValue) aConfig.nTrigObj = atof(argv[++iArg]);
+    else if(arg=="--data") aConfig.isData = true;
+    else if(arg=="--seed" && hasValue) aConfig.seed = atoi(argv[++iArg]);
+    else if((arg=="-i" || arg=="--input") && hasValue) inputFile = argv[++iArg];
+    else if((arg=="-c" || arg=="--channel") && hasValue) channel = argv[++iArg];
+    else if((arg=="-j" || arg=="--threads") && hasValue) nThreads = atoi(argv[++iArg]);
+    else if(arg=="-s" || arg=="--svfit") doSvFit = true;
+    else if(arg=="-r" || arg=="--recoil") applyRecoil = true;
+    else if(arg=="-t" || arg=="--timing") stageTimes = true;
+    else if(arg=="-k" || arg=="--keep") keep = true;
+    else{
+      std::cout<<"[benchmarkNano]: Unknown or incomplete option "<<arg<<std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<std::string> channels;
+  if(channel=="each"){
+    channels.push_back("mt");
+    channels.push_back("et");
+    channels.push_back("tt");
+    channels.push_back("all");
+  }
+  else if(channel=="mt" || channel=="et" || channel=="tt" || channel=="all") channels.push_back(channel);
+  else{
+    usage(argv[0]);
+    return 1;
+  }
+
+  bool synthetic = inputFile.empty();
+  if(synthetic){
+    inputFile = aConfig.isData ? "synthetic_nano_data.root" : "synthetic_nano_mc.root";
+    SyntheticNano aGenerator(aConfig);
+    if(!aGenerator.write(inputFile)){
+      std::cout<<"[benchmarkNano]: Cannot write synthetic input"<<std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<BenchmarkResult> results(channels.size());
+  std::vector<bool> passed(channels.size(), false);
+  for(unsigned int iChannel=0;iChannel<channels.size();++iChannel){
+    std::cout<<"[benchmarkNano]: Converting channel "<<channels[iChannel]<<std::endl;
+    passed[iChannel] = forkChannel(inputFile, channels[iChannel], nThreads, doSvFit, applyRecoil, stageTimes, results[iChannel]);
+  }
+
+  ///Outputs are named after the input, see initHTTTree()
+  std::string baseName = inputFile.substr(inputFile.find_last_of('/')+1);
+  if(!keep){
+    const char *prefixes[] = {"HTTMT_", "HTTET_", "HTTTT_"};
+    for(unsigned int iPrefix=0;iPrefix<3;++iPrefix) gSystem->Unlink((prefixes[iPrefix]+baseName).c_str());
+    if(synthetic) gSystem->Unlink(inputFile.c_str());
+  }
+
+  std::cout<<"[benchmarkNano]: Input "<<baseName<<", "<<nThreads<<" thread(s)"
+	   <<(doSvFit ? ", SVfit" : "")<<(applyRecoil ? ", recoil corrections" : "")<<std::endl;
+  char line[256];
+  snprintf(line, sizeof(line), "%-8s %10s %10s %10s %12s %14s %12s",
+	   "channel", "events", "wall [s]", "cpu [s]", "events/s", "bytes/event", "peak RSS [MB]");
+  std::cout<<"\t"<<line<<std::endl;
+  bool allPassed = true;
+  for(unsigned int iChannel=0;iChannel<channels.size();++iChannel){
+    const BenchmarkResult &aResult = results[iChannel];
+    if(!passed[iChannel]){
+      std::cout<<"\t"<<channels[iChannel]<<": conversion failed"<<std::endl;
+      allPassed = false;
+      continue;
+    }
+    snprintf(line, sizeof(line), "%-8s %10lld %10.2f %10.2f %12.1f %14.1f %12.1f",
+	     channels[iChannel].c_str(), aResult.entries, aResult.wallTime, aResult.cpuTime,
+	     aResult.wallTime>0 ? aResult.entries/aResult.wallTime : 0.,
+	     aResult.entries>0 ? double(aResult.bytesRead)/aResult.entries : 0.,
+	     aResult.peakRSS/1024.);
+    std::cout<<"\t"<<line<<std::endl;
+  }
+  return allPassed ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+/*****************************
+* Output equivalence and performance regression check of two
+* builds of convertNano: both convert the same input, rows of
+* TauCheck trees are matched by (run, lumi, evt) and all branches
+* but the row numbering (entry, fileEntry) are compared within
+* tolerances, for outputs of all inputs; wall time and events/s of the
+* new build are compared to the reference one.
+* Exit code is 0 only if outputs agree and there is no regression.
+*****************************/
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TLeaf.h>
+#include <TH1.h>
+#include <TSystem.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+void usage(const char *name){
+
+  std::cout<<"Usage: "<<name<<" --ref EXE --new EXE [options] file1 [file2 ...]"<<std::endl
+	   <<"       "<<name<<" --ref-file FILE --new-file FILE [options]"<<std::endl
+	   <<"  --ref, --new EXE         convertNano builds, each runs in its own directory"<<std::endl
+	   <<"  --args \"ARGS\"            options passed to both builds (default: \"-c all\")"<<std::endl
+	   <<"  --repeat N               runs of each build, the fastest one is used (default: 1)"<<std::endl
+	   <<"  --max-slowdown X         allowed loss of events/s of the new build, fraction (default: 0.05)"<<std::endl
+	   <<"  --ref-file, --new-file   compare existing outputs only"<<std::endl
+	   <<"  --rtol X, --atol X       relative and absolute tolerance of all branches (default: 0, exact)"<<std::endl
+	   <<"  --tol BRANCH=X           relative tolerance of a branch, can be repeated"<<std::endl
+	   <<"  --ignore BRANCH          branch not compared, can be repeated"<<std::endl
+	   <<"  --compare BRANCH         compare also a branch ignored by default (entry, fileEntry: row bookkeeping"<<std::endl
+	   <<"                           which differs between serial and threaded runs), can be repeated"<<std::endl
+	   <<"  --max-print N            mismatches printed per branch (default: 3)"<<std::endl;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+struct Tolerance {
+  double relative, absolute;
+};
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+struct CompareOptions {
+  Tolerance tolerance;
+  std::map<std::string,double> branchTolerances;
+  std::vector<std::string> ignored;
+  unsigned int maxPrint;
+};
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+bool sameValue(double a, double b, const Tolerance &aTolerance){
+
+  if(std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+  if(a==b) return true;
+  return std::abs(a-b)<=aTolerance.absolute+aTolerance.relative*std::max(std::abs(a),std::abs(b));
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+///Rows of TauCheck by (run, lumi, evt)
+struct EventKey {
+  Long64_t run, lumi;
+  ULong64_t evt;
+  bool operator<(const EventKey &other) const {
+    if(run!=other.run) return run<other.run;
+    if(lumi!=other.lumi) return lumi<other.lumi;
+    return evt<other.evt;
+  }
+};
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+bool indexRows(TTree *aTree, std::map<EventKey,Long64_t> &rows){
+
+  TLeaf *run = aTree->GetLeaf("run"), *lumi = aTree->GetLeaf("lumi"), *evt = aTree->GetLeaf("evt");
+  if(run==nullptr || lumi==nullptr || evt==nullptr){
+    std::cout<<"[compareTauCheck]: No run, lumi or evt branch in "<<aTree->GetCurrentFile()->GetName()<<std::endl;
+    return false;
+  }
+  aTree->SetBranchStatus("*",0);
+  aTree->SetBranchStatus("run",1);
+  aTree->SetBranchStatus("lumi",1);
+  aTree->SetBranchStatus("evt",1);
+  unsigned int nDuplicates = 0;
+  for(Long64_t iRow=0;iRow<aTree->GetEntries();++iRow){
+    aTree->GetEntry(iRow);
+    EventKey aKey;
+    aKey.run = std::llround(run->GetValue());
+    aKey.lumi = std::llround(lumi->GetValue());
+    aKey.evt = evt->GetValueLong64();
+    if(!rows.insert(std::make_pair(aKey,iRow)).second) ++nDuplicates;
+  }
+  aTree->SetBranchStatus("*",1);
+  if(nDuplicates) std::cout<<"[compareTauCheck]: "<<nDuplicates<<" rows with the same (run, lumi, evt) in "
+			  <<aTree->GetCurrentFile()->GetName()<<", only the first one is compared"<<std::endl;
+  return true;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+///Compare TauCheck trees of two files, true if they agree
+bool compareFiles(const std::string &refName, const std::string &newName, const CompareOptions &options){
+
+  std::cout<<"[compareTauCheck]: Comparing "<<newName<<" to "<<refName<<std::endl;
+  TFile refFile(refName.c_str()), newFile(newName.c_str());
+  TTree *refTree = refFile.IsZombie() ? nullptr : (TTree*)refFile.Get("TauCheck");
+  TTree *newTree = newFile.IsZombie() ? nullptr : (TTree*)newFile.Get("TauCheck");
+  if(refTree==nullptr || newTree==nullptr){
+    std::cout<<"\tTauCheck tree missing"<<std::endl;
+    return false;
+  }
+  bool agree = true;
+
+  ///Bookkeeping: events analyzed and saved
+  TH1 *refStats = (TH1*)refFile.Get("hStats"), *newStats = (TH1*)newFile.Get("hStats");
+  if(refStats && newStats){
+    for(int iBin=1;iBin<=4;++iBin){
+      if(refStats->GetBinContent(iBin)==newStats->GetBinContent(iBin)) continue;
+      std::cout<<"\thStats bin "<<iBin<<": "<<refStats->GetBinContent(iBin)<<" -> "<<newStats->GetBinContent(iBin)<<std::endl;
+      agree = false;
+    }
+  }
+
+  std::map<EventKey,Long64_t> refRows, newRows;
+  if(!indexRows(refTree, refRows) || !indexRows(newTree, newRows)) return false;
+
+  ///Rows of one output only
+  unsigned int nOnlyRef = 0, nOnlyNew = 0;
+  std::vector<std::pair<Long64_t,Long64_t> > pairs;
+  for(std::map<EventKey,Long64_t>::const_iterator it=refRows.begin();it!=refRows.end();++it){
+    std::map<EventKey,Long64_t>::const_iterator itNew = newRows.find(it->first);
+    if(itNew==newRows.end()){
+      if(nOnlyRef++<options.maxPrint) std::cout<<"\tonly in reference: "<<it->first.run<<":"<<it->first.lumi<<":"<<it->first.evt<<std::endl;
+    }
+    else pairs.push_back(std::make_pair(it->second, itNew->second));
+  }
+  for(std::map<EventKey,Long64_t>::const_iterator it=newRows.begin();it!=newRows.end();++it){
+    if(refRows.count(it->first)) continue;
+    if(nOnlyNew++<options.maxPrint) std::cout<<"\tonly in new: "<<it->first.run<<":"<<it->first.lumi<<":"<<it->first.evt<<std::endl;
+  }
+  std::cout<<"\t"<<refRows.size()<<" reference rows, "<<newRows.size()<<" new rows, "<<pairs.size()<<" matched, "
+	   <<nOnlyRef<<" only in reference, "<<nOnlyNew<<" only in new"<<std::endl;
+  if(nOnlyRef || nOnlyNew) agree = false;
+
+  ///Branches of both trees
+  struct Compared {
+    std::string name;
+    TLeaf *refLeaf, *newLeaf;
+    Tolerance tolerance;
+    unsigned int nDiffs;
+    double maxDiff;
+  };
+  std::vector<Compared> compared;
+  TObjArray *refLeaves = refTree->GetListOfLeaves();
+  for(int iLeaf=0;iLeaf<refLeaves->GetEntries();++iLeaf){
+    TLeaf *refLeaf = (TLeaf*)refLeaves->At(iLeaf);
+    std::string name = refLeaf->GetName();
+    bool ignore = false;
+    for(unsigned int iIgnored=0;iIgnored<options.ignored.size();++iIgnored) ignore |= options.ignored[iIgnored]==name;
+    if(ignore) continue;
+    TLeaf *newLeaf = newTree->GetLeaf(name.c_str());
+    if(newLeaf==nullptr){
+      std::cout<<"\tbranch "<<name<<" missing in new output"<<std::endl;
+      agree = false;
+      continue;
+    }
+    Compared aCompared = {name, refLeaf, newLeaf, options.tolerance, 0, 0};
+    std::map<std::string,double>::const_iterator itTol = options.branchTolerances.find(name);
+    if(itTol!=options.branchTolerances.end()) aCompared.tolerance.relative = itTol->second;
+    compared.push_back(aCompared);
+  }
+  TObjArray *newLeaves = newTree->GetListOfLeaves();
+  for(int iLeaf=0;iLeaf<newLeaves->GetEntries();++iLeaf){
+    if(refTree->GetLeaf(newLeaves->At(iLeaf)->GetName())!=nullptr) continue;
+    std::cout<<"\tbranch "<<newLeaves->At(iLeaf)->GetName()<<" only in new output"<<std::endl;
+    agree = false;
+  }
+
+  ///Values of matched rows
+  for(unsigned int iPair=0;iPair<pairs.size();++iPair){
+    refTree->GetEntry(pairs[iPair].first);
+    newTree->GetEntry(pairs[iPair].second);
+    for(unsigned int iBranch=0;iBranch<compared.size();++iBranch){
+      Compared &aCompared = compared[iBranch];
+      int nValues = std::max(aCompared.refLeaf->GetLen(), aCompared.newLeaf->GetLen());
+      for(int iValue=0;iValue<nValues;++iValue){
+	double refValue = iValue<aCompared.refLeaf->GetLen() ? aCompared.refLeaf->GetValue(iValue) : NAN;
+	double newValue = iValue<aCompared.newLeaf->GetLen() ? aCompared.newLeaf->GetValue(iValue) : NAN;
+	if(sameValue(refValue, newValue, aCompared.tolerance)) continue;
+	if(aCompared.nDiffs++<options.maxPrint)
+	  std::cout<<"\t"<<aCompared.name<<" of "<<refTree->GetLeaf("run")->GetValue()<<":"
+		   <<std::llround(refTree->GetLeaf("lumi")->GetValue())<<":"<<refTree->GetLeaf("evt")->GetValueLong64()
+		   <<" differs: "<<refValue<<" -> "<<newValue<<std::endl;
+	double diff = std::abs(refValue-newValue);
+	if(!std::isnan(diff)) aCompared.maxDiff = std::max(aCompared.maxDiff, diff);
+	break;
+      }
+    }
+  }
+  unsigned int nBranchesDiffer = 0;
+  for(unsigned int iBranch=0;iBranch<compared.size();++iBranch){
+    const Compared &aCompared = compared[iBranch];
+    if(aCompared.nDiffs==0) continue;
+    ++nBranchesDiffer;
+    std::cout<<"\tbranch "<<aCompared.name<<": "<<aCompared.nDiffs<<" rows differ, max. difference "<<aCompared.maxDiff<<std::endl;
+  }
+  std::cout<<"\t"<<compared.size()<<" branches compared, "<<nBranchesDiffer<<" differ"<<std::endl;
+  return agree && nBranchesDiffer==0;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+///Run a build in its directory, outputs are moved here with names prefixed by the tag;
+///outputs are returned without the tag; wall time in seconds, <0 if failed
+double runBuild(const std::string &exe, const std::string &args, const std::vector<std::string> &files,
+		const std::string &tag, std::vector<std::string> &outputs){
+
+  std::string dir(gSystem->DirName(exe.c_str()));
+  std::string command = "cd "+dir+" && ./"+gSystem->BaseName(exe.c_str())+" "+args;
+  for(unsigned int iFile=0;iFile<files.size();++iFile) command += " "+files[iFile];
+  command += " > "+std::string(gSystem->WorkingDirectory())+"/log_"+tag+".txt 2>&1";
+  std::cout<<"[compareTauCheck]: Running "<<command<<std::endl;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int status = system(command.c_str());
+  double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  if(status!=0){
+    std::cout<<"[compareTauCheck]: "<<exe<<" failed, see log_"<<tag<<".txt"<<std::endl;
+    return -1;
+  }
+  ///Outputs are named after their input, or after the first one when inputs
+  ///are converted as one chain, see HTauTauTreeFromNanoBase::initHTTTree()
+  const char *prefixes[] = {"HTTMT_", "HTTET_", "HTTTT_"};
+  outputs.clear();
+  for(unsigned int iFile=0;iFile<files.size();++iFile){
+    std::string baseName = gSystem->BaseName(files[iFile].c_str());
+    for(unsigned int iPrefix=0;iPrefix<3;++iPrefix){
+      std::string name = prefixes[iPrefix]+baseName;
+      std::string output = dir+"/"+name;
+      if(gSystem->AccessPathName(output.c_str())) continue;
+      if(std::find(outputs.begin(), outputs.end(), name)!=outputs.end()) continue;
+      if(gSystem->Rename(output.c_str(), (tag+"_"+name).c_str())==0) outputs.push_back(name);
+    }
+  }
+  return wallTime;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+///Events analyzed by a conversion, from the bookkeeping histogram
+double eventsAnalyzed(const std::string &fileName){
+
+  TFile aFile(fileName.c_str());
+  TH1 *hStats = aFile.IsZombie() ? nullptr : (TH1*)aFile.Get("hStats");
+  return hStats ? hStats->GetBinContent(1) : 0;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+  std::string refExe, newExe, refFile, newFile;
+  std::string args = "-c all";
+  unsigned int nRepeat = 1;
+  double maxSlowdown = 0.05;
+  CompareOptions options;
+  options.tolerance.relative = 0;
+  options.tolerance.absolute = 0;
+  options.maxPrint = 3;
+  options.ignored.push_back("entry");
+  options.ignored.push_back("fileEntry");
+  std::vector<std::string> files;
+
+  for(int iArg=1;iArg<argc;++iArg){
+    std::string arg = argv[iArg];
+    bool hasValue = iArg+1<argc;
+    if(arg=="-h" || arg=="--help"){ usage(argv[0]); return 0; }
+    else if(arg=="--ref" && hasValue) refExe = argv[++iArg];
+    else if(arg=="--new" && hasValue) newExe = argv[++iArg];
+    else if(arg=="--args" && hasValue) args = argv[++iArg];
+    else if(arg=="--repeat" && hasValue) nRepeat = std::max(1,atoi(argv[++iArg]));
+    else if(arg=="--max-slowdown" && hasValue) maxSlowdown = atof(argv[++iArg]);
+    else if(arg=="--ref-file" && hasValue) refFile = argv[++iArg];
+    else if(arg=="--new-file" && hasValue) newFile = argv[++iArg];
+    else if(arg=="--rtol" && hasValue) options.tolerance.relative = atof(argv[++iArg]);
+    else if(arg=="--atol" && hasValue) options.tolerance.absolute = atof(argv[++iArg]);
+    else if(arg=="--tol" && hasValue){
+      std::string aTolerance = argv[++iArg];
+      std::size_t pos = aTolerance.find('=');
+      if(pos==std::string::npos){ usage(argv[0]); return 1; }
+      options.branchTolerances[aTolerance.substr(0,pos)] = atof(aTolerance.substr(pos+1).c_str());
+    }
+    else if(arg=="--ignore" && hasValue) options.ignored.push_back(argv[++iArg]);
+    else if(arg=="--compare" && hasValue){
+      std::string aBranch = argv[++iArg];
+      options.ignored.erase(std::remove(options.ignored.begin(), options.ignored.end(), aBranch), options.ignored.end());
+    }
+    else if(arg=="--max-print" && hasValue) options.maxPrint = atoi(argv[++iArg]);
+    else if(!arg.empty() && arg[0]=='-'){
+      std::cout<<"[compareTauCheck]: Unknown or incomplete option "<<arg<<std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+    else files.push_back(arg);
+  }
+
+  ///Existing outputs only
+  if(!refFile.empty() || !newFile.empty()){
+    if(refFile.empty() || newFile.empty()){ usage(argv[0]); return 1; }
+    bool agree = compareFiles(refFile, newFile, options);
+    std::cout<<"[compareTauCheck]: Outputs "<<(agree ? "agree" : "DIFFER")<<std::endl;
+    return agree ? 0 : 1;
+  }
+  if(refExe.empty() || newExe.empty() || files.empty()){
+    usage(argv[0]);
+    return 1;
+  }
+  ///Builds run in their directories
+  for(unsigned int iFile=0;iFile<files.size();++iFile){
+    if(files[iFile].find(":/")!=std::string::npos || gSystem->IsAbsoluteFileName(files[iFile].c_str())) continue;
+    files[iFile] = std::string(gSystem->WorkingDirectory())+"/"+files[iFile];
+  }
+
+  ///Fastest of the runs, outputs of the last one
+  std::vector<std::string> refOutputs, newOutputs;
+  double refTime = -1, newTime = -1;
+  for(unsigned int iRun=0;iRun<nRepeat;++iRun){
+    double aTime = runBuild(refExe, args, files, "ref", refOutputs);
+    if(aTime<0) return 1;
+    refTime = refTime<0 ? aTime : std::min(refTime, aTime);
+    aTime = runBuild(newExe, args, files, "new", newOutputs);
+    if(aTime<0) return 1;
+    newTime = newTime<0 ? aTime : std::min(newTime, aTime);
+  }
+  if(refOutputs.empty() || refOutputs!=newOutputs){
+    std::cout<<"[compareTauCheck]: Builds wrote different outputs:"<<std::endl;
+    for(unsigned int iOutput=0;iOutput<refOutputs.size();++iOutput) std::cout<<"\treference: "<<refOutputs[iOutput]<<std::endl;
+    for(unsigned int iOutput=0;iOutput<newOutputs.size();++iOutput) std::cout<<"\tnew: "<<newOutputs[iOutput]<<std::endl;
+    return 1;
+  }
+
+  bool agree = true;
+  for(unsigned int iOutput=0;iOutput<refOutputs.size();++iOutput)
+    agree &= compareFiles("ref_"+refOutputs[iOutput], "new_"+newOutputs[iOutput], options);
+
+  ///Each channel analyzes all events: events of one channel summed over outputs of all inputs
+  double nEvents = 0;
+  std::string channelPrefix = refOutputs[0].substr(0, refOutputs[0].find('_')+1);
+  for(unsigned int iOutput=0;iOutput<refOutputs.size();++iOutput)
+    if(refOutputs[iOutput].compare(0, channelPrefix.size(), channelPrefix)==0) nEvents += eventsAnalyzed("ref_"+refOutputs[iOutput]);
+  double refRate = refTime>0 ? nEvents/refTime : 0;
+  double newRate = newTime>0 ? nEvents/newTime : 0;
+  bool regression = newRate<(1-maxSlowdown)*refRate;
+  char line[256];
+  snprintf(line, sizeof(line), "%-10s %10s %12s", "build", "wall [s]", "events/s");
+  std::cout<<"[compareTauCheck]: "<<nEvents<<" events, fastest of "<<nRepeat<<" run(s)"<<std::endl
+	   <<"\t"<<line<<std::endl;
+  snprintf(line, sizeof(line), "%-10s %10.2f %12.1f", "reference", refTime, refRate);
+  std::cout<<"\t"<<line<<std::endl;
+  snprintf(line, sizeof(line), "%-10s %10.2f %12.1f  (%+.1f%%)", "new", newTime, newRate,
+	   refRate>0 ? 100*(newRate/refRate-1) : 0.);
+  std::cout<<"\t"<<line<<std::endl;
+
+  std::cout<<"[compareTauCheck]: Outputs "<<(agree ? "agree" : "DIFFER")
+	   <<", performance "<<(regression ? "REGRESSED" : "ok")<<std::endl;
+  return agree && !regression ? 0 : 1;
+}
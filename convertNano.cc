@@ -0,0 +1,168 @@
+/*****************************
+* Standalone driver of the conversion, linked against the prebuilt
+* libHTTFromNano.so (see Makefile) to avoid compilation in each job.
+*****************************/
+
+#include "HMuTauhTreeFromNano.h"
+#include "HElTauhTreeFromNano.h"
+#include "HTauhTauhTreeFromNano.h"
+
+#include <TFile.h>
+#include <TChain.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <stdexcept>
+
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+void usage(const char *name){
+
+  std::cout<<"Usage: "<<name<<" [options] file1 [file2 ...]"<<std::endl
+	   <<"  -c, --channel mt|et|tt|all  channel(s) to convert (default: all)"<<std::endl
+	   <<"  -n, --nevents N             events to convert per file (per chain with threads), -1: all (default)"<<std::endl
+	   <<"  -l, --lumis FILE            lumi ranges to accept, run:ls-run:ls separated by commas or blanks"<<std::endl
+	   <<"  -s, --svfit                 compute SVfit"<<std::endl
+	   <<"      --svfit-workers N       run SVfit in N worker processes"<<std::endl
+	   <<"      --svfit-cache DIR       store SVfit results in DIR and reuse them"<<std::endl
+	   <<"      --skim-index DIR        store lists of entries with a row in DIR, later runs convert only those"<<std::endl
+	   <<"      --no-recoil             do not apply MET recoil corrections"<<std::endl
+	   <<"  -j, --threads N             convert in N threads, several files as one chain"<<std::endl
+	   <<"      --range-entries N       entries per range converted by a thread"<<std::endl
+	   <<"      --tree-cache BYTES      TTreeCache size, -1: ROOT default, 0: no cache"<<std::endl
+	   <<"      --sync-event N          event number to print debug information for"<<std::endl
+	   <<"  -t, --timing                time stages of the event loop, stored as StageTimes tree in outputs"<<std::endl;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+std::vector<std::string> readLumis(const std::string &fileName){
+
+  std::vector<std::string> lumis;
+  std::ifstream in(fileName.c_str());
+  if(!in){
+    std::cout<<"[convertNano]: Cannot read lumi ranges from "<<fileName<<std::endl;
+    exit(1);
+  }
+  std::string line;
+  while(std::getline(in,line)){
+    for(unsigned int iChar=0;iChar<line.size();++iChar)
+      if(line[iChar]==',' || line[iChar]=='"' || line[iChar]=='\'') line[iChar] = ' ';
+    std::istringstream words(line);
+    std::string aRange;
+    while(words>>aRange) lumis.push_back(aRange);
+  }
+  return lumis;
+}
+/////////////////////////////////////////////////
+/////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+  std::string channel = "all";
+  Long64_t nEvents = -1;
+  std::vector<std::string> lumis;
+  bool doSvFit = false;
+  unsigned int svFitWorkers = 0;
+  std::string svFitCacheDir;
+  std::string skimIndexDir;
+  bool applyRecoil = true;
+  unsigned int loopThreads = 1;
+  Long64_t loopRangeEntries = 0;
+  Long64_t treeCacheSize = -1;
+  unsigned int syncEvent = 0;
+  bool stageTimes = false;
+  std::vector<std::string> fileNames;
+
+  for(int iArg=1;iArg<argc;++iArg){
+    std::string arg = argv[iArg];
+    bool hasValue = iArg+1<argc;
+    if(arg=="-h" || arg=="--help"){ usage(argv[0]); return 0; }
+    else if((arg=="-c" || arg=="--channel") && hasValue) channel = argv[++iArg];
+    else if((arg=="-n" || arg=="--nevents") && hasValue) nEvents = atoll(argv[++iArg]);
+    else if((arg=="-l" || arg=="--lumis") && hasValue) lumis = readLumis(argv[++iArg]);
+    else if(arg=="-s" || arg=="--svfit") doSvFit = true;
+    else if(arg=="--svfit-workers" && hasValue) svFitWorkers = atoi(argv[++iArg]);
+    else if(arg=="--svfit-cache" && hasValue) svFitCacheDir = argv[++iArg];
+    else if(arg=="--skim-index" && hasValue) skimIndexDir = argv[++iArg];
+    else if(arg=="--no-recoil") applyRecoil = false;
+    else if((arg=="-j" || arg=="--threads") && hasValue) loopThreads = atoi(argv[++iArg]);
+    else if(arg=="--range-entries" && hasValue) loopRangeEntries = atoll(argv[++iArg]);
+    else if(arg=="--tree-cache" && hasValue) treeCacheSize = atoll(argv[++iArg]);
+    else if(arg=="--sync-event" && hasValue) syncEvent = atoi(argv[++iArg]);
+    else if(arg=="-t" || arg=="--timing") stageTimes = true;
+    else if(!arg.empty() && arg[0]=='-'){
+      std::cout<<"[convertNano]: Unknown or incomplete option "<<arg<<std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+    else fileNames.push_back(arg);
+  }
+  if(fileNames.empty() || (channel!="mt" && channel!="et" && channel!="tt" && channel!="all")){
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::cout<<"[convertNano]: Channel: "<<channel<<std::endl;
+  if(doSvFit) std::cout<<"[convertNano]: Run with SVFit computation"<<std::endl;
+  if(applyRecoil) std::cout<<"[convertNano]: Apply MET recoil corrections"<<std::endl;
+
+  ///With threads all files are one chain: ranges of entries of all files are shared
+  ///by the threads and converted into one output per channel, named after the first file
+  std::vector<std::vector<std::string> > jobs;
+  if(loopThreads>1) jobs.push_back(fileNames);
+  else for(unsigned int iFile=0;iFile<fileNames.size();++iFile)
+	 jobs.push_back(std::vector<std::string>(1,fileNames[iFile]));
+
+  for(unsigned int iJob=0;iJob<jobs.size();++iJob){
+    TChain *aChain = new TChain("Events");
+    for(unsigned int iFile=0;iFile<jobs[iJob].size();++iFile){
+      std::string aFile = jobs[iJob][iFile];
+      if(aFile.find(":/")==std::string::npos) aFile = "file://"+aFile;
+      std::cout<<"[convertNano]: Using file: "<<aFile<<std::endl;
+      aChain->Add(aFile.c_str());
+    }
+    std::cout<<"[convertNano]: TChain entries: "<<aChain->GetEntries()<<std::endl;
+    if(aChain->LoadTree(0)<0){
+      std::cout<<"[convertNano]: Cannot read input, skipping it"<<std::endl;
+      delete aChain;
+      continue;
+    }
+
+    std::vector<HTauTauTreeFromNanoBase*> converters;
+    ///Malformed lumi ranges are reported by the converters
+    try{
+      if(channel=="mt" || channel=="all") converters.push_back(new HMuTauhTreeFromNano(aChain,doSvFit,applyRecoil,lumis));
+      if(channel=="et" || channel=="all") converters.push_back(new HElTauhTreeFromNano(aChain,doSvFit,applyRecoil,lumis));
+      if(channel=="tt" || channel=="all") converters.push_back(new HTauhTauhTreeFromNano(aChain,doSvFit,applyRecoil,lumis));
+    }
+    catch(const std::invalid_argument &e){
+      std::cout<<"[convertNano]: "<<e.what()<<std::endl;
+      for(unsigned int iConverter=0;iConverter<converters.size();++iConverter){
+	converters[iConverter]->fChain = nullptr;
+	delete converters[iConverter];
+      }
+      delete aChain;
+      return 1;
+    }
+    ///All channels are converted in one pass over the input driven by the first converter
+    for(unsigned int iConverter=1;iConverter<converters.size();++iConverter)
+      converters[0]->addChannel(converters[iConverter]);
+    converters[0]->setSvFitWorkers(svFitWorkers);
+    converters[0]->setSvFitCacheDir(svFitCacheDir);
+    converters[0]->setSkimIndexDir(skimIndexDir);
+    converters[0]->setTreeCache(treeCacheSize);
+    converters[0]->setLoopThreads(loopThreads,loopRangeEntries);
+    converters[0]->setStageTimes(stageTimes);
+    converters[0]->Loop(nEvents,syncEvent);
+    ///Input file is owned by the chain, not by the converters
+    for(unsigned int iConverter=0;iConverter<converters.size();++iConverter){
+      converters[iConverter]->fChain = nullptr;
+      delete converters[iConverter];
+    }
+    delete aChain;
+  }
+  return 0;
+}
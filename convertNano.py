@@ -35,33 +35,37 @@ if applyRecoil :
 
 #Some system have problem runnig compilation (missing glibc-static library?).
 #First we try to compile, and only then we start time consuming cmssw
-status = gSystem.CompileMacro('HTTEvent.cxx','k')
-status *= gSystem.CompileMacro('syncDATA.C','k')
-#status *= gSystem.CompileMacro('NanoEventsSkeleton.C') #RECOMPILE IF IT CHANGES!
-gSystem.Load('NanoEventsSkeleton_C.so')
-gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisClassicSVfit.so')
-gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisSVfitTF.so')
-gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libHTT-utilitiesRecoilCorrections.so')
-
-# xline=gSystem.GetMakeSharedLib()+' -Wattributes'
-# xline=xline.replace(' -W ',' -W -Wattributes ')
-# gSystem.SetMakeSharedLib(xline)
-# print 'MMM ',gSystem.GetMakeSharedLib()
-
-# yline=gSystem.GetMakeExe()+' -Wattributes'
-# yline=yline.replace(' -W ',' -W -Wattributes ')
-# gSystem.SetMakeExe(yline)
-# print 'NNN ',gSystem.GetMakeExe()
-
-stdout = sys.stdout
-sys.stdout = open('/tmp/pstd', 'w')
-stderr = sys.stderr
-sys.stderr = open('/tmp/perr', 'w')
-status *= gSystem.CompileMacro('HTauTauTreeFromNanoBase.C','k')
-status *= gSystem.CompileMacro('HMuTauhTreeFromNano.C','k')
-status *= gSystem.CompileMacro('HTauhTauhTreeFromNano.C','k')
-sys.stdout=stdout
-sys.stderr=stderr
+#Library prebuilt with make is used when present, otherwise sources are compiled here
+if os.path.exists('libHTTFromNano.so'):
+    status = int(gSystem.Load('libHTTFromNano.so')>=0)
+else:
+    status = gSystem.CompileMacro('HTTEvent.cxx','k')
+    status *= gSystem.CompileMacro('syncDATA.C','k')
+    #status *= gSystem.CompileMacro('NanoEventsSkeleton.C') #RECOMPILE IF IT CHANGES!
+    gSystem.Load('NanoEventsSkeleton_C.so')
+    gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisClassicSVfit.so')
+    gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisSVfitTF.so')
+    gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libHTT-utilitiesRecoilCorrections.so')
+
+    # xline=gSystem.GetMakeSharedLib()+' -Wattributes'
+    # xline=xline.replace(' -W ',' -W -Wattributes ')
+    # gSystem.SetMakeSharedLib(xline)
+    # print 'MMM ',gSystem.GetMakeSharedLib()
+
+    # yline=gSystem.GetMakeExe()+' -Wattributes'
+    # yline=yline.replace(' -W ',' -W -Wattributes ')
+    # gSystem.SetMakeExe(yline)
+    # print 'NNN ',gSystem.GetMakeExe()
+
+    stdout = sys.stdout
+    sys.stdout = open('/tmp/pstd', 'w')
+    stderr = sys.stderr
+    sys.stderr = open('/tmp/perr', 'w')
+    status *= gSystem.CompileMacro('HTauTauTreeFromNanoBase.C','k')
+    status *= gSystem.CompileMacro('HMuTauhTreeFromNano.C','k')
+    status *= gSystem.CompileMacro('HTauhTauhTreeFromNano.C','k')
+    sys.stdout=stdout
+    sys.stderr=stderr
 
 print "Compilation status: ",status
 if status==0:
@@ -9,13 +9,27 @@ from ROOT import gSystem, TChain, TSystem, TFile, TString, vector
 from PSet import process
 
 #dir = "/data/higgs/nanonaod_2016/PUMoriond17_05Feb2018_94X_mcRun2_asymptotic_v2-v1/VBFHToTauTau_M125_13TeV_powheg_pythia8/"
+#usage: convertNanoParallel.py channel [-j nThreads] file1 [file2 ...]
 channel = sys.argv[1]
-fileNames = [ sys.argv[2] ]
+args = sys.argv[2:]
+loopThreads = 1 #>1: convert the input in that many threads, each reading ranges of entries
+if len(args)>1 and args[0]=='-j':
+    loopThreads = int(args[1])
+    args = args[2:]
+fileNames = args
 
 #sync_event=850381
 sync_event=0
 #doSvFit = True
 doSvFit = False
+svFitWorkers = 0 #>0: run SVFit in that many parallel worker processes
+svFitCacheDir = '' #if set, SVFit results are stored there and reused by later runs
+skimIndexDir = '' #if set, lists of entries with a row are stored there and later runs with the same selection convert only those
+loopRangeEntries = 0 #entries per range converted by a thread, 0: a few ranges per thread
+treeCacheSize = -1 #bytes of TTreeCache for the input, -1: ROOT default, 0: no cache
+treeCacheLearnEntries = 0 #entries to learn branches to cache, 0: only branches declared by the converter
+treeCachePrefetch = False #asynchronous prefetching of next clusters, useful for remote inputs
+stageTimes = False #time stages of the event loop, summary printed and stored as StageTimes tree in outputs
 applyRecoil=True
 #applyRecoil=False
 nevents=-1      #all
@@ -32,35 +46,39 @@ if applyRecoil :
 
 #Some system have problem runnig compilation (missing glibc-static library?).
 #First we try to compile, and only then we start time consuming cmssw
-status = 1
-gSystem.CompileMacro('HTTEvent.cxx','k')
-status *= gSystem.CompileMacro('syncDATA.C','k')
-#status *= gSystem.CompileMacro('NanoEventsSkeleton.C') #RECOMPILE IF IT CHANGES!
-status *= gSystem.CompileMacro('NanoEventsSkeleton.C','k')
-gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisClassicSVfit.so')
-gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisSVfitTF.so')
-gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libHTT-utilitiesRecoilCorrections.so')
-
-# xline=gSystem.GetMakeSharedLib()+' -Wattributes'
-# xline=xline.replace(' -W ',' -W -Wattributes ')
-# gSystem.SetMakeSharedLib(xline)
-# print 'MMM ',gSystem.GetMakeSharedLib()
-
-# yline=gSystem.GetMakeExe()+' -Wattributes'
-# yline=yline.replace(' -W ',' -W -Wattributes ')
-# gSystem.SetMakeExe(yline)
-# print 'NNN ',gSystem.GetMakeExe()
-
-stdout = sys.stdout
-sys.stdout = open('/tmp/pstd', 'w')
-stderr = sys.stderr
-sys.stderr = open('/tmp/perr', 'w')
-status *= gSystem.CompileMacro('HTauTauTreeFromNanoBase.C','k')
-if channel=='mt' or channel=='all': status *= gSystem.CompileMacro('HMuTauhTreeFromNano.C','k')
-if channel=='et' or channel=='all': status *= gSystem.CompileMacro('HElTauhTreeFromNano.C','k')
-if channel=='tt' or channel=='all': status *= gSystem.CompileMacro('HTauhTauhTreeFromNano.C','k')
-sys.stdout=stdout
-sys.stderr=stderr
+#Library prebuilt with make is used when present, otherwise sources are compiled here
+if os.path.exists('libHTTFromNano.so'):
+    status = int(gSystem.Load('libHTTFromNano.so')>=0)
+else:
+    status = 1
+    gSystem.CompileMacro('HTTEvent.cxx','k')
+    status *= gSystem.CompileMacro('syncDATA.C','k')
+    #status *= gSystem.CompileMacro('NanoEventsSkeleton.C') #RECOMPILE IF IT CHANGES!
+    status *= gSystem.CompileMacro('NanoEventsSkeleton.C','k')
+    gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisClassicSVfit.so')
+    gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libTauAnalysisSVfitTF.so')
+    gSystem.Load('$CMSSW_BASE/lib/$SCRAM_ARCH/libHTT-utilitiesRecoilCorrections.so')
+
+    # xline=gSystem.GetMakeSharedLib()+' -Wattributes'
+    # xline=xline.replace(' -W ',' -W -Wattributes ')
+    # gSystem.SetMakeSharedLib(xline)
+    # print 'MMM ',gSystem.GetMakeSharedLib()
+
+    # yline=gSystem.GetMakeExe()+' -Wattributes'
+    # yline=yline.replace(' -W ',' -W -Wattributes ')
+    # gSystem.SetMakeExe(yline)
+    # print 'NNN ',gSystem.GetMakeExe()
+
+    stdout = sys.stdout
+    sys.stdout = open('/tmp/pstd', 'w')
+    stderr = sys.stderr
+    sys.stderr = open('/tmp/perr', 'w')
+    status *= gSystem.CompileMacro('HTauTauTreeFromNanoBase.C','k')
+    if channel=='mt' or channel=='all': status *= gSystem.CompileMacro('HMuTauhTreeFromNano.C','k')
+    if channel=='et' or channel=='all': status *= gSystem.CompileMacro('HElTauhTreeFromNano.C','k')
+    if channel=='tt' or channel=='all': status *= gSystem.CompileMacro('HTauhTauhTreeFromNano.C','k')
+    sys.stdout=stdout
+    sys.stderr=stderr
 
 print "Compilation status: ",status
 if status==0:
@@ -76,8 +94,35 @@ lumisToProcess = process.source.lumisToProcess
 for lumi in lumisToProcess:
     vlumis.push_back(lumi)
 
-threads = []
-ctr=0
+def runConverters(aTree):
+    converters = []
+    if channel=='mt' or channel=='all': converters.append( HMuTauhTreeFromNano(  aTree,doSvFit,applyRecoil,vlumis) )
+    if channel=='et' or channel=='all': converters.append( HElTauhTreeFromNano(  aTree,doSvFit,applyRecoil,vlumis) )
+    if channel=='tt' or channel=='all': converters.append( HTauhTauhTreeFromNano(aTree,doSvFit,applyRecoil,vlumis) )
+    #all channels are converted in one pass over the input driven by the first converter
+    for aConverter in converters[1:]:
+        converters[0].addChannel(aConverter)
+    converters[0].setSvFitWorkers(svFitWorkers)
+    converters[0].setSvFitCacheDir(svFitCacheDir)
+    converters[0].setSkimIndexDir(skimIndexDir)
+    converters[0].setTreeCache(treeCacheSize,treeCacheLearnEntries,treeCachePrefetch)
+    converters[0].setLoopThreads(loopThreads,loopRangeEntries)
+    converters[0].setStageTimes(stageTimes)
+    converters[0].Loop(nevents,sync_event)
+    del converters
+
+#with threads all files are one chain: ranges of entries of all files are shared
+#by the threads and converted into one output per channel, named after the first file
+if loopThreads>1 and len(fileNames)>1:
+    aChain = TChain("Events")
+    for name in fileNames:
+        print "Using file: ","file://"+name
+        aChain.Add("file://"+name)
+    print "TChain entries: ",aChain.GetEntries()
+    aChain.LoadTree(0)
+    runConverters(aChain)
+    exit(0)
+
 for name in fileNames:
 #    aFile = "file:///home/mbluj/work/data/NanoAOD/80X_with944/VBFHToTauTau_M125_13TeV_powheg_pythia8/RunIISummer16NanoAOD_PUMoriond17_05Feb2018_94X_mcRun2_asymptotic_v2-v1/"+name
     aFile = "file://"+name
@@ -86,9 +131,7 @@ for name in fileNames:
     aROOTFile = TFile.Open(aFile)
     aTree = aROOTFile.Get("Events")
     print "TTree entries: ",aTree.GetEntries()
-    if channel=='mt' or channel=='all': HMuTauhTreeFromNano(  aTree,doSvFit,applyRecoil,vlumis).Loop(nevents,sync_event)
-    if channel=='et' or channel=='all': HElTauhTreeFromNano(  aTree,doSvFit,applyRecoil,vlumis).Loop(nevents,sync_event)
-    if channel=='tt' or channel=='all': HTauhTauhTreeFromNano(aTree,doSvFit,applyRecoil,vlumis).Loop(nevents,sync_event)
+    runConverters(aTree)
 
 #    print 'A',name,threading.active_count()
 #    t = threading.Thread(target=runFile, args=(aFile,) )
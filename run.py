@@ -1,8 +1,6 @@
 #!/usr/bin/env python
 
 import sys, os
-import threading
-from time import sleep
 
 channel='et'
 
@@ -10,17 +8,6 @@ nthreads = 6
 #dir = '/afs/hephy.at/work/m/mflechl/cmssw/CMSSW_9_4_4_fromNano/src/WawTools/NanoAODTools/'
 dir = os.getcwd()+'/'
 
-def runOneFile(idx,file):
-#    os.system('cp -p *so *pcm '+dir+'rundir_'+channel+'_'+str(idx))
-    print str(idx),file,dir+'rundir_'+channel+'_'+str(idx)
-    os.system('cp -p *h *cxx *C *cc PSet.py zpt*root '+dir+'rundir_'+channel+'_'+str(idx))
-    os.system('cp -p '+dir+'convertNanoParallel.py '+dir+'rundir_'+channel+'_'+str(idx))
-    os.chdir(dir+'rundir_'+channel+'_'+str(idx))
-    os.system('rm -f HTT*root')
-    os.system('./convertNanoParallel.py '+channel+' '+file+' &>log.txt')
-    os.chdir(dir)
-    print str(idx)+' done'
-
 print 'Channel:',channel
 
 #2016 sync
@@ -52,30 +39,17 @@ fileNames = [
 #    "FA4F6F5B-9043-E811-8DB2-0CC47A4D76C8.root",
 #]
 
-#commented out: when rerunning, will only recompile what is needed.
-#os.system('rm -rf rundir_'+channel+'_*')
-
-threads = []
-ctr=0
-for idx,file in enumerate(fileNames):
-    if not os.path.exists(dir+'rundir_'+channel+'_'+str(idx)):
-        os.makedirs(dir+'rundir_'+channel+'_'+str(idx))
-    t = threading.Thread(target=runOneFile, args=(idx,dirName+file,) )
-    threads += [t]
-
-    while threading.active_count()>nthreads:  #pause until thread slots become available
-        pass
-
-    #avoid problems when all start at the same time
-    sleep(5)
-
-    t.start()
-
-
-for x in threads:
-    x.join()
-
-#hadd -O ntuples/v15_mt.root rundir_'+channel+'_*/HTTM*root
-if channel=='et' or channel=='all': os.system('hadd -f -O ntuple_et.root rundir_'+channel+'_*/HTTE*root')
-if channel=='mt' or channel=='all': os.system('hadd -f -O ntuple_mt.root rundir_'+channel+'_*/HTTM*root')
-if channel=='tt' or channel=='all': os.system('hadd -f -O ntuple_tt.root rundir_'+channel+'_*/HTTT*root')
+#library and executable are built once (only changed sources are recompiled),
+#all files are converted in one process: entry ranges of all files are shared
+#by nthreads threads, a thread done with its ranges takes over ranges of others
+if os.system('make -j'+str(nthreads))!=0:
+    print 'Build failed'
+    sys.exit(1)
+files = ' '.join([dirName+file for file in fileNames])
+os.system('./convertNano -c '+channel+' -j '+str(nthreads)+' '+files+' &>log_'+channel+'.txt')
+
+#one output per channel, named after the first input file
+firstName = os.path.basename(fileNames[0])
+if channel=='et' or channel=='all': os.rename('HTTET_'+firstName,'ntuple_et.root')
+if channel=='mt' or channel=='all': os.rename('HTTMT_'+firstName,'ntuple_mt.root')
+if channel=='tt' or channel=='all': os.rename('HTTTT_'+firstName,'ntuple_tt.root')
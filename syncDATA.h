@@ -2,12 +2,85 @@
 #include "TTree.h"
 #include "TLorentzVector.h"
 //#include "TMatrixD.h"
-#include "TMatrixDEigen.h"
+#include "EtaPhiIndex.h"
 
 
 #ifndef __syncDATA__
 #define __syncDATA__
 
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Read-only view of the jets filled to the sync tree:
+/// precomputed kinematics and the properties used by
+/// syncDATA as parallel arrays of the given size, owned
+/// by a SyncJetTable and valid until it is next changed.
+struct SyncJetView{
+  unsigned int size;
+  const double *pt, *eta, *phi, *mass;
+  const double *px, *py, *pz, *e;
+  const double *rawFactor, *btagCMVA, *btagCSVV2, *partonFlavour;
+
+  TLorentzVector p4(unsigned int i) const {return TLorentzVector(px[i], py[i], pz[i], e[i]);}
+};
+
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// Jets of an event as filled by the converter next to
+/// its HTTParticle collection. Storage is kept between
+/// events, so filling does not allocate once warmed up.
+class SyncJetTable{
+
+ public:
+
+  void clear(){
+    for(unsigned int iColumn=0;iColumn<kNColumns;++iColumn) columns_[iColumn].clear();
+  }
+
+  void add(const HTTParticle &aJet){
+    const TLorentzVector &p4 = aJet.getP4();
+    columns_[kPt].push_back(p4.Pt());
+    columns_[kEta].push_back(p4.Eta());
+    columns_[kPhi].push_back(p4.Phi());
+    columns_[kMass].push_back(p4.M());
+    columns_[kPx].push_back(p4.Px());
+    columns_[kPy].push_back(p4.Py());
+    columns_[kPz].push_back(p4.Pz());
+    columns_[kE].push_back(p4.E());
+    columns_[kRawFactor].push_back(aJet.getProperty(PropertyEnum::rawFactor));
+    columns_[kBtagCMVA].push_back(aJet.getProperty(PropertyEnum::btagCMVA));
+    columns_[kBtagCSVV2].push_back(aJet.getProperty(PropertyEnum::btagCSVV2));
+    columns_[kPartonFlavour].push_back(aJet.getProperty(PropertyEnum::partonFlavour));
+  }
+
+  unsigned int size() const {return columns_[kPt].size();}
+
+  SyncJetView view() const {
+    SyncJetView aView;
+    aView.size = size();
+    aView.pt = columns_[kPt].data();
+    aView.eta = columns_[kEta].data();
+    aView.phi = columns_[kPhi].data();
+    aView.mass = columns_[kMass].data();
+    aView.px = columns_[kPx].data();
+    aView.py = columns_[kPy].data();
+    aView.pz = columns_[kPz].data();
+    aView.e = columns_[kE].data();
+    aView.rawFactor = columns_[kRawFactor].data();
+    aView.btagCMVA = columns_[kBtagCMVA].data();
+    aView.btagCSVV2 = columns_[kBtagCSVV2].data();
+    aView.partonFlavour = columns_[kPartonFlavour].data();
+    return aView;
+  }
+
+ private:
+
+  enum Column {kPt, kEta, kPhi, kMass, kPx, kPy, kPz, kE,
+	       kRawFactor, kBtagCMVA, kBtagCSVV2, kPartonFlavour, kNColumns};
+
+  std::vector<double> columns_[kNColumns];
+
+};
+
 class syncDATA
 {
  public:
@@ -328,16 +401,22 @@ class syncDATA
   ~syncDATA(){}  
 
   void setDefault();
-  void fill(HTTEvent *ev, std::vector<HTTParticle> jets, HTTPair *pair);
+  void fill(HTTEvent *ev, const SyncJetView &jets, const HTTPair *pair);
+  void fillSVFit(const HTTPair *pair);
   void initTree(TTree *t, bool isMC_, bool isSync_);
 
-  double calcSphericity(std::vector<TLorentzVector> p);
-  double calcSphericityFromMatrix(TMatrixD M);
+  double calcSphericity(const TLorentzVector *p, unsigned int n);
+  static double calcSphericityFromMatrix(double s00, double s01, double s02,
+					 double s11, double s12, double s22);
 
-  int getGenMatch_jetId(TLorentzVector selObj, std::vector<HTTParticle> jets);
+  int getGenMatch_jetId(double eta, double phi, const SyncJetView &jets);
 
   double calcDR(double eta1, double phi1, double eta2, double phi2);
 
+  ///Index of jets used by getGenMatch_jetId, filled once per event in fill()
+  EtaPhiIndex jetIndex;
+  std::vector<unsigned int> jetMatchCandidates;
+
   //////////////////////////////////////////////////////////////////
   int nadditionalMu;
   vector<double> addmuon_pt;